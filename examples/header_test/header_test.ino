@@ -1,9 +1,19 @@
 // simple test that the header files compile.
 
 #include <MCCI_Catena_SGPC3.h>
+#include <MCCI_Catena_SGPC3_Filter.h>
+#include <MCCI_Catena_SGPC3_Registry.h>
+
+using namespace McciCatenaSGPC3;
+
+// the filters and the registry are templates, so instantiate them to check that they compile.
+cFilterPipeline<cHampelFilter<7>, cMedianFilter<5>, cDecimator<30>> gFilter;
+cSGPC3_Registry<std::uint16_t, 2> gRegistry;
 
 void setup()
-    {}
+    {
+    gRegistry.scan();
+    }
 
 void loop()
     {}
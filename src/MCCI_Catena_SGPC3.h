@@ -52,6 +52,8 @@ namespace std {
 }
 #endif
 
+// for offsetof(); AVR has no <cstddef>.
+#include <stddef.h>
 #include <Wire.h>
 
 
@@ -159,6 +161,245 @@ constexpr std::uint32_t kVersion = makeVersion(0,1,0,0);
 //  endgroup version
 /// \}
 
+/****************************************************************************\
+|
+|   The bus arbiter.
+|
+\****************************************************************************/
+
+/// \defgroup arbiter Shared-bus arbitration
+/// \{
+
+/*!
+
+\brief Abstract interface for sharing an I2C bus among several drivers.
+
+\details
+    Sensors like the SGPC3 spend most of a transaction waiting: a command
+    is written, and then the host must wait 10 to 220 ms before reading
+    the response. During that time the bus itself is idle, and could be
+    used by other drivers (for example, an SHT3x on the same bus).
+
+    Drivers derive a client from \ref cBusArbiter::cClient and register
+    it with an arbiter. Before using the bus, a client calls acquire();
+    when finished, it calls release(). When a client must wait for its
+    device, it calls waitIdle() instead of \c delay(), advertising the
+    window during which it will not use the bus. The arbiter may use
+    that window to run pending transactions of other clients, in order
+    of priority.
+
+    A client that has started a transaction and will need the bus again
+    at a known time (as the SGPC3 does, to read a response) reports that
+    time with getNextBusTime(), so that the arbiter can avoid starting
+    lower-priority transactions that would still be running then.
+
+    The library supplies a simple cooperative implementation,
+    \ref cBusArbiterSimple.
+
+*/
+class cBusArbiter
+    {
+public:
+    /// \brief Type of value returned by \c millis().
+    using Millisecond_t = decltype(millis());
+    /// \brief Type used for bus-time estimates, in microseconds.
+    using Microsecond_t = std::uint32_t;
+
+    /// \brief Priority of a client.
+    enum class Priority_t : std::uint8_t
+        {
+        Low = 0,                    ///< Background traffic; never runs ahead of other clients.
+        Normal = 1,                 ///< Normal traffic.
+        High = 2,                   ///< Urgent traffic; runs ahead of lower-priority clients.
+        };
+
+    /// \brief Base class for drivers that share the bus.
+    class cClient
+        {
+        friend class cBusArbiter;
+
+    public:
+        cClient()
+            : m_pNext(nullptr)
+            , m_pArbiter(nullptr)
+            , m_priority(Priority_t::Normal)
+            {}
+
+        /// \brief Return the estimated bus time of the client's next pending transaction.
+        ///
+        /// \returns
+        ///     The estimated time (in microseconds) that the bus will be busy
+        ///     if pollBus() is called, or zero if the client has nothing to do.
+        ///     The default implementation returns zero.
+        virtual Microsecond_t getPendingBusTimeUs() const
+            {
+            return 0;
+            }
+
+        /// \brief Run the client's next pending transaction.
+        ///
+        /// \details
+        ///     Called by the arbiter only if getPendingBusTimeUs() returned
+        ///     non-zero. The default implementation does nothing.
+        virtual void pollBus()
+            {}
+
+        /// \brief Report when the client will next need the bus.
+        ///
+        /// \param tDue [out]   Set to the time (in \c millis()) when the
+        ///                     client expects to need the bus.
+        ///
+        /// \returns
+        ///     \c true if the client has a transaction in progress that will
+        ///     need the bus at \p tDue, \c false if not. The default
+        ///     implementation returns \c false.
+        virtual bool getNextBusTime(Millisecond_t &tDue) const
+            {
+            (void) tDue;
+            return false;
+            }
+
+        /// \brief Get the priority assigned when the client was registered.
+        Priority_t getPriority() const
+            {
+            return this->m_priority;
+            }
+
+        /// \brief Get the arbiter this client is registered with, or \c nullptr.
+        cBusArbiter *getArbiter() const
+            {
+            return this->m_pArbiter;
+            }
+
+        /// \brief Get the next client registered with the same arbiter.
+        cClient *getNext() const
+            {
+            return this->m_pNext;
+            }
+
+    protected:
+        ~cClient() = default;
+
+    private:
+        /// \brief Link to next client registered with the same arbiter.
+        cClient *m_pNext;
+        /// \brief The arbiter, or \c nullptr if not registered.
+        cBusArbiter *m_pArbiter;
+        /// \brief The client's priority.
+        Priority_t m_priority;
+        };
+
+    cBusArbiter()
+        : m_pClients(nullptr)
+        {}
+
+    /// \brief Instances of this class are neither copyable nor movable.
+    cBusArbiter(const cBusArbiter&) = delete;
+    /// \brief Instances of this class are neither copyable nor movable.
+    cBusArbiter& operator=(const cBusArbiter&) = delete;
+    /// \brief Instances of this class are neither copyable nor movable.
+    cBusArbiter(const cBusArbiter&&) = delete;
+    /// \brief Instances of this class are neither copyable nor movable.
+    cBusArbiter& operator=(const cBusArbiter&&) = delete;
+
+    /// \brief Register a client with this arbiter.
+    bool registerClient(cClient &client, Priority_t priority = Priority_t::Normal);
+
+    /// \brief Remove a client from this arbiter.
+    void unregisterClient(cClient &client);
+
+    /// \brief Get the first registered client, or \c nullptr.
+    cClient *getClients() const
+        {
+        return this->m_pClients;
+        }
+
+    /// \brief Obtain the bus for a transaction.
+    ///
+    /// \param client [in]      The client that wants the bus.
+    /// \param busTimeUs [in]   Estimated duration of the transaction, in microseconds.
+    ///
+    /// \details
+    ///     Once a client has called acquire(), it's going to use the bus,
+    ///     so \p busTimeUs is advisory: an arbiter may use it for
+    ///     scheduling or accounting, but can't refuse the transaction.
+    virtual void acquire(cClient &client, Microsecond_t busTimeUs) = 0;
+
+    /// \brief Release the bus after a transaction.
+    virtual void release(cClient &client) = 0;
+
+    /// \brief Wait, advertising that the client will not use the bus.
+    ///
+    /// \param client [in]  The waiting client.
+    /// \param tUntil [in]  The time (in \c millis()) when the client's
+    ///                     window ends. The function returns no earlier
+    ///                     than this time.
+    virtual void waitIdle(cClient &client, Millisecond_t tUntil) = 0;
+
+protected:
+    ~cBusArbiter() = default;
+
+    /// \brief Head of list of registered clients.
+    cClient *m_pClients;
+    };
+
+/*!
+
+\brief Simple cooperative bus arbiter.
+
+\details
+    This arbiter assumes that all clients run in the same thread of
+    control (the normal case for Arduino sketches). In acquire(), any
+    pending transactions from clients with higher priority than the
+    caller are run first. In waitIdle(), pending transactions are run
+    in priority order as long as their estimated bus time fits in
+    the remaining window, and doesn't run into the next bus time
+    (see cClient::getNextBusTime()) of any other client with higher
+    priority than the transaction's owner.
+
+    cBusArbiterSimple doesn't use the estimate passed to acquire().
+
+*/
+class cBusArbiterSimple : public cBusArbiter
+    {
+public:
+    /// \brief Margin (in microseconds) kept free at the end of an idle window.
+    static constexpr Microsecond_t kGuardUs = 1000;
+
+    cBusArbiterSimple()
+        : m_pOwner(nullptr)
+        , m_pWaiter(nullptr)
+        {}
+
+    virtual void acquire(cClient &client, Microsecond_t busTimeUs) override;
+    virtual void release(cClient &client) override;
+    virtual void waitIdle(cClient &client, Millisecond_t tUntil) override;
+
+    /// \brief Get the client that currently owns the bus, or \c nullptr.
+    cClient *getOwner() const
+        {
+        return this->m_pOwner;
+        }
+
+private:
+    /// \brief Find the best pending client.
+    cClient *findPending(const cClient *pSkip, Priority_t minPriority, Microsecond_t budgetUs) const;
+
+    /// \brief Check whether a transaction would run into a higher-priority client's next bus time.
+    bool isBlockedBy(const cClient *pCandidate, Microsecond_t busTimeUs) const;
+
+    /// \brief Find the earliest future bus time reported by the other clients.
+    bool getNextBusTime(const cClient *pSkip, Millisecond_t &tNext) const;
+
+    /// \brief The client that currently owns the bus.
+    cClient *m_pOwner;
+    /// \brief The client whose idle window is being filled.
+    cClient *m_pWaiter;
+    };
+
+// end group arbiter
+/// \}
+
 /****************************************************************************\
 |
 |   The sensor class.
@@ -254,6 +495,13 @@ enum class cSGPC3_cmds::Command_t : std::uint32_t {
     measure_tvoc_and_raw           = CommandInit(0x2046, 0, 6, 50),    ///< Get TVOC and raw data.
     measure_raw                    = CommandInit(0x204d, 0, 3, 50),    ///< Measure raw concentration.
     set_absolute_humidity          = CommandInit(0x2061, 3, 0, 10, 6), ///< Set absolute humidity.
+
+    /// \brief Initialize continuous operation mode, skipping the preheat period.
+    /// \note
+    ///     This is defined by the Sensirion sample code (not the datasheet), which requires
+    ///     feature set >= 6. It's intended for use when a valid baseline is restored
+    ///     immediately afterwards.
+    tvoc_init_no_preheat           = CommandInit(0x2089, 0, 0, 10, 6),
     
     /// \brief Set power mode (low or ultralow)
     /// \note The sample code requires feature set >= 6.
@@ -262,7 +510,7 @@ enum class cSGPC3_cmds::Command_t : std::uint32_t {
     /// \brief Initialize continuous operation mode.
     /// \note
     ///     The sample code requires feature set >= 6. It also defines two addtional commands, `tvoc_init_no_preheat`
-    ///     and `SGPC3_CMD_IAQ_INIT_64`; the latter is unused and otherwise undocumented. 
+    ///     (which this library also supports) and `SGPC3_CMD_IAQ_INIT_64`; the latter is unused and otherwise undocumented.
     tvoc_init_continuous           = CommandInit(0x20ae, 0, 0, 10),    ///< Initialize continuous operation mode
 
     /// \brief Get the inceptive base line.
@@ -292,16 +540,15 @@ enum class cSGPC3_cmds::Command_t : std::uint32_t {
 
 
 ///
-class cSGPC3 : public cSGPC3_cmds
+class cSGPC3 : public cSGPC3_cmds, public cBusArbiter::cClient
     {
 private:
-    /// \brief Type of value returned by \c millis().
-    using Millisecond_t = decltype(millis());
-
     /// \brief Control result of isDebug(); use for compiling debug code in/out.
     static constexpr bool kfDebug = false;
 
 public:
+    /// \brief Type of value returned by \c millis().
+    using Millisecond_t = decltype(millis());
 
     /// \brief The SCPC3 I2C address. This is fixed by design.
     static constexpr std::int8_t kAddress = 0x58;
@@ -318,8 +565,20 @@ public:
     /// \brief Time (in milliseconds) between measurements in ultra-low-power mode
     static constexpr Millisecond_t kTultraLowPowerMs = 30000;
 
+    /// \brief Time (in milliseconds) after `tvoc_init_continuous` before data is valid, in low-power mode.
+    static constexpr Millisecond_t kTpreheatLowPowerMs = 64000;
+
+    /// \brief Time (in milliseconds) after `tvoc_init_continuous` before data is valid, in ultra-low-power mode.
+    static constexpr Millisecond_t kTpreheatUltraLowPowerMs = 184000;
+
+    /// \brief Maximum age (in milliseconds) of a saved baseline that is considered fresh.
+    static constexpr std::uint32_t kBaselineMaxAgeMs = 7u * 24u * 60u * 60u * 1000u;
+
+    /// \brief Estimated bus time (in microseconds) per byte at 100 kHz.
+    static constexpr cBusArbiter::Microsecond_t kBusUsPerByte = 90;
+
     /// \brief Common result codes for this library.
-    enum class Error_t
+    enum class Error_t : std::uint8_t
         {
         Success,                    ///< The operation was a succcess.
         Failure,                    ///< The operation failed for no specific reason.
@@ -350,11 +609,131 @@ public:
         Low = 1,                    ///< Low-power mode.
         };
 
+    /// \brief How begin() starts continuous measurement.
+    enum class StartupPolicy_t
+        {
+        Preheat,                    ///< Always use `tvoc_init_continuous`, with the full preheat period; restore any baseline.
+        NoPreheat,                  ///< Always use `tvoc_init_no_preheat`; restore any baseline.
+        Auto,                       ///< If a fresh baseline is supplied, skip the preheat and restore it; otherwise preheat, and ignore the baseline.
+        };
+
+    /// \brief A saved baseline, for restoring with begin().
+    struct Baseline_t
+        {
+        std::uint16_t value;        ///< The baseline, as returned by get_tvoc_baseline_synchronous().
+        std::uint32_t ageMs;        ///< Time (in milliseconds) since the baseline was saved.
+        };
+
+    /// \brief Description of a completed command, as passed to observers.
+    struct Transaction_t
+        {
+        Command_t command;          ///< The command that was sent.
+        std::uint16_t param;        ///< The parameter word, or zero if the command takes none.
+        Error_t result;             ///< The result of the bus transfer (CRCs are checked later, from \c response).
+        std::uint8_t i2cResult;     ///< The result of \c endTransmission() for the command write.
+        std::uint8_t nResponse;     ///< The number of response bytes read.
+        std::uint8_t response[9];   ///< The raw response bytes (including CRCs), before checking.
+        Millisecond_t tStart;       ///< The time (in \c millis()) when the command was written (after any arbitration).
+        std::uint32_t tStartUs;     ///< The time (in \c micros()) when the command was written (after any arbitration).
+        std::uint32_t tEndUs;       ///< The time (in \c micros()) when the transaction completed.
+        std::uint32_t arbitrationUs; ///< Time (in microseconds) spent in cBusArbiter::acquire() before reading the response; part of \c tEndUs - \c tStartUs.
+        };
+
+    /// \brief Result of a measurement, returned by value.
+    ///
+    /// \details
+    ///     This is a plain structure of fixed-width fields (16 bytes, host byte
+    ///     order), laid out so that the compiler adds no padding; the spare
+    ///     bytes at the end are an explicit \c reserved field, which is always
+    ///     zero. So a result can be copied into buffers or queues as-is.
+    ///     Fields that the command doesn't return are zero.
+    struct Measurement_t
+        {
+        std::uint32_t tCapture;     ///< When the command was written, in \c millis().
+        std::uint16_t tvoc;         ///< TVOC in ppb, if measured.
+        std::uint16_t raw;          ///< Raw signal in ticks, if measured.
+        std::uint16_t ageMs;        ///< Time since the sensor last updated its output (or since start, before the first update), at capture.
+        std::uint16_t command;      ///< The SGPC3 command code used (for example, 0x2008 for `measure_tvoc`).
+        Error_t error;              ///< Result of the command.
+        std::uint8_t flags;         ///< Combination of \c kFlag... bits.
+        std::uint16_t reserved;     ///< Always zero.
+
+        /// \brief Set if the values were read successfully.
+        static constexpr std::uint8_t kFlagSuccess = 1u << 0;
+        /// \brief Set if this is the first read since the sensor last updated its output.
+        ///
+        /// \details
+        ///     The sensor's first output is at the end of its first measurement
+        ///     period; reads before then are never fresh.
+        static constexpr std::uint8_t kFlagFresh = 1u << 1;
+        /// \brief Set if the sensor's data was valid (preheat complete) at capture.
+        static constexpr std::uint8_t kFlagValid = 1u << 2;
+
+        /// \brief Test whether the measurement succeeded.
+        constexpr bool isSuccess() const { return (this->flags & kFlagSuccess) != 0; }
+        /// \brief Test whether the values are new since the previous read.
+        constexpr bool isFresh() const { return (this->flags & kFlagFresh) != 0; }
+        /// \brief Test whether the sensor's data was valid at capture.
+        constexpr bool isValid() const { return (this->flags & kFlagValid) != 0; }
+        };
+
+    /// \brief Base class for objects that observe the sensor's bus traffic.
+    ///
+    /// \details
+    ///     Observers are linked into a list owned by the sensor (see
+    ///     addObserver()), so no allocation is needed. Because the link
+    ///     is part of the observer, an observer can watch only one sensor
+    ///     at a time. Callbacks are made synchronously from the driver,
+    ///     and so must be quick.
+    class cObserver
+        {
+        friend class cSGPC3;
+
+    public:
+        cObserver()
+            : m_pNext(nullptr)
+            , m_pSensor(nullptr)
+            {}
+
+        /// \brief Get the sensor this observer is watching, or \c nullptr.
+        cSGPC3 *getSensor() const
+            {
+            return this->m_pSensor;
+            }
+
+        /// \brief Called after each command has been sent (successfully or not).
+        virtual void onTransaction(const Transaction_t &t) = 0;
+
+        /// \brief Called when the driver is told that the chip has been reset.
+        virtual void onChipReset(Millisecond_t when)
+            {
+            (void) when;
+            }
+
+    protected:
+        ~cObserver() = default;
+
+    private:
+        /// \brief Link to next observer of the same sensor.
+        cObserver *m_pNext;
+        /// \brief The sensor being watched, or \c nullptr.
+        cSGPC3 *m_pSensor;
+        };
+
 public:
     /// \brief Construct an instance on a given I2C bus.
     /// \param wire [in]  I2C bus (or repeater) to be used for this sensor.
     cSGPC3(TwoWire &wire)
             : m_wire(&wire)
+            , m_pObservers(nullptr)
+            , m_powerMode(PowerMode_t::Low)
+            , m_tAvail(kTpuMs)
+            , m_tDataValid(0)
+            , m_tStarted(0)
+            , m_lastUpdate(0)
+            , m_featureSet(0)
+            , m_fStarted(false)
+            , m_fPending(false)
             {}
 
     /// \brief Instances of this class are neither copyable nor movable.
@@ -367,7 +746,13 @@ public:
     cSGPC3& operator=(const cSGPC3&&) = delete;
 
     /// \brief Initialze the SGPC3, and fetch the feature set.
-    Error_t begin(PowerMode_t mode = PowerMode_t::UltraLow);
+    Error_t begin(PowerMode_t mode = PowerMode_t::UltraLow)
+        {
+        return this->begin(mode, StartupPolicy_t::Preheat, nullptr);
+        }
+
+    /// \brief Initialze the SGPC3, fetch the feature set, and optionally restore a baseline.
+    Error_t begin(PowerMode_t mode, StartupPolicy_t policy, const Baseline_t *pBaseline);
 
     /// \brief Deinitialize the SGPC3.
     void end();
@@ -375,6 +760,73 @@ public:
     /// \brief Query whether the library was built with debugging enabled.
     static constexpr bool isDebug() { return kfDebug; }
 
+    /// \brief Share the I2C bus with other drivers using an arbiter.
+    ///
+    /// \param pArbiter [in]    The arbiter, or \c nullptr to stop using one.
+    /// \param priority [in]    The priority of this sensor's traffic.
+    ///
+    /// \details
+    ///     Once an arbiter is set, the driver brackets each bus transfer with
+    ///     cBusArbiter::acquire() and cBusArbiter::release(), and waits for
+    ///     command completion using cBusArbiter::waitIdle(), so that other
+    ///     clients can use the bus while the SGPC3 is busy.
+    bool setArbiter(cBusArbiter *pArbiter, cBusArbiter::Priority_t priority = cBusArbiter::Priority_t::Normal);
+
+    /// \brief Add an observer of this sensor's bus traffic.
+    ///
+    /// \returns
+    ///     \c true if the observer was added, \c false if it is already
+    ///     watching a sensor (this one or another).
+    bool addObserver(cObserver &observer)
+        {
+        if (observer.m_pSensor != nullptr)
+            return false;
+
+        observer.m_pSensor = this;
+        observer.m_pNext = this->m_pObservers;
+        this->m_pObservers = &observer;
+        return true;
+        }
+
+    /// \brief Remove an observer of this sensor's bus traffic.
+    void removeObserver(cObserver &observer);
+
+    /// \brief Report when the sensor will next need the bus.
+    ///
+    /// \details
+    ///     While a command started by startCommand() is in progress, this is
+    ///     the time when the response (if any) can be read. The SGPC3 driver
+    ///     never has transactions for the arbiter to poll: all its bus
+    ///     traffic is run from the caller's thread.
+    virtual bool getNextBusTime(Millisecond_t &tDue) const override
+        {
+        if (! this->m_fPending || getResponseLength(this->m_pending.command) == 0)
+            return false;
+
+        tDue = this->m_tAvail;
+        return true;
+        }
+
+    /// \brief Get the time (in \c millis()) when the sensor will next accept a command.
+    Millisecond_t getAvailableTime() const
+        {
+        return this->m_tAvail;
+        }
+
+    /// \brief Estimate the bus time needed to transfer a command and its response.
+    ///
+    /// \details
+    ///     The estimate assumes a 100 kHz bus (nine bit-times per byte), and
+    ///     counts the address bytes, command, parameters and response. It
+    ///     doesn't include the delay between command and response.
+    static constexpr cBusArbiter::Microsecond_t getBusTimeUs(Command_t c)
+        {
+        return kBusUsPerByte * (
+                (1 + 2 + 3 * getParameterLength(c)) +
+                (getResponseLength(c) == 0 ? 0 : 1 + 3 * getResponseLength(c))
+                );
+        }
+
 protected:
     /// \brief Send command with neither parameter nor response.
     /// \tparam c   The command to be sent.
@@ -455,6 +907,48 @@ protected:
         return this->sendCommandWithThreeResponses(c, response);
         }
 
+    /// \brief Start a command that takes no parameter, without waiting for the response.
+    /// \tparam c   The command to be sent.
+    /// \details
+    ///     Check (at compile time) whether the command can be used with this routine.
+    ///     Check (at run time) whether the command is supported by the discovered sensor.
+    ///     Launch the command, but don't wait; the caller must call getAsyncResponse()
+    ///     with the same command before sending any other command to this sensor;
+    ///     starting another command (or a chip reset) abandons this one.
+    ///     This allows commands to several sensors to be overlapped.
+    ///
+    /// \returns
+    ///     This operation returns \ref Error_t::Success, some other code for failure.
+    ///     Use isSuccess() to check for success or failure.
+    ///
+    template <Command_t c>
+    Error_t sendAsync()
+        {
+        static_assert(getParameterLength(c) == 0, "command takes parameters");
+        auto eSupported = this->isSupported(c);
+        if (! isSuccess(eSupported))
+            return eSupported;
+        return this->startCommand(c, nullptr);
+        }
+    /// \brief Complete a command started by sendAsync(), with one response.
+    /// \tparam c   The command that was sent.
+    /// \param response [out]   Set to the response, in host-native byte order.
+    template <Command_t c>
+    Error_t getAsyncResponse(std::uint16_t &response)
+        {
+        static_assert(getResponseLength(c) == 1, "command response length != 1");
+        return this->finishCommandWithResponse(c, response);
+        }
+    /// \brief Complete a command started by sendAsync(), with a 64-bit response.
+    /// \tparam c   The command that was sent.
+    /// \param response [out]   set to the 3-word response formatted as a uint64_t in host-native byte order.
+    template <Command_t c>
+    Error_t getAsyncResponse(std::uint64_t &response)
+        {
+        static_assert(getResponseLength(c) == 3, "command response length != 3");
+        return this->finishCommandWithThreeResponses(c, response);
+        }
+
 private:
     /// \brief Send command without parameter or response.
     Error_t sendCommandBare(Command_t c);
@@ -468,6 +962,20 @@ private:
     Error_t sendCommandWithThreeResponses(Command_t c, std::uint64_t &response);
     /// \brief Send command, parameter bytes, result bytes
     Error_t sendCommand(Command_t c, const std::uint8_t *pParamBytes, std::uint8_t *pResultBytes);
+    /// \brief Write command and parameter bytes, without waiting for completion.
+    Error_t startCommand(Command_t c, const std::uint8_t *pParamBytes);
+    /// \brief Wait for a started command to complete, and read its result bytes.
+    Error_t finishCommand(Command_t c, std::uint8_t *pResultBytes);
+    /// \brief Finish a started command with one response word
+    Error_t finishCommandWithResponse(Command_t c, std::uint16_t &response);
+    /// \brief Finish a started command with three response words
+    Error_t finishCommandWithThreeResponses(Command_t c, std::uint64_t &response);
+    /// \brief Pass the most recent transaction to the observers.
+    void notifyObservers() const;
+    /// \brief Check and cache the response to `get_feature_set_version`.
+    Error_t setFeatureSet(std::uint16_t featureSet);
+    /// \brief Wait until a given time, letting other arbiter clients use the bus.
+    void waitUntil(Millisecond_t tUntil);
 
     /// \brief Product type codes.
     enum class ProductType_t : std::uint8_t
@@ -510,9 +1018,117 @@ public:
         auto result = this->isSupported(Command_t::tvoc_init_continuous);
         if (isSuccess(result))
             result = this->sendSynchronous<Command_t::tvoc_init_continuous>();
+        if (isSuccess(result))
+            this->setDataValidTime(
+                this->m_powerMode == PowerMode_t::UltraLow ? kTpreheatUltraLowPowerMs : kTpreheatLowPowerMs
+                );
+        return result;
+        }
+
+    /// \brief Set the sensor into continuous measurement mode, without preheating.
+    ///
+    /// \details
+    ///     The data is considered valid after the first measurement period. The
+    ///     caller should restore a saved baseline immediately afterwards.
+    Error_t tvoc_init_no_preheat(void)
+        {
+        auto result = this->sendSynchronous<Command_t::tvoc_init_no_preheat>();
+        if (isSuccess(result))
+            this->setDataValidTime(this->getMeasurementPeriodMs());
         return result;
         }
 
+    /// \brief Get the 48-bit serial ID of the sensor.
+    Error_t get_serial_id_synchronous(std::uint64_t &serialId)
+        {
+        return this->sendAndGetSynchronous<Command_t::get_serial_id>(serialId);
+        }
+
+    /// \brief Start reading the serial ID; see get_serial_id_finish().
+    ///
+    /// \details
+    ///     The split-phase form lets several sensors be queried in one pass.
+    Error_t get_serial_id_start()
+        {
+        return this->sendAsync<Command_t::get_serial_id>();
+        }
+
+    /// \brief Finish reading the serial ID started by get_serial_id_start().
+    Error_t get_serial_id_finish(std::uint64_t &serialId)
+        {
+        return this->getAsyncResponse<Command_t::get_serial_id>(serialId);
+        }
+
+    /// \brief Start reading the feature set; see get_feature_set_finish().
+    Error_t get_feature_set_start()
+        {
+        return this->sendAsync<Command_t::get_feature_set_version>();
+        }
+
+    /// \brief Finish reading the feature set started by get_feature_set_start().
+    ///
+    /// \param featureSet [out] Set to the raw feature-set word.
+    ///
+    /// \details
+    ///     As with begin(), the device type and version are checked, and the
+    ///     result is cached for use by getFeatureSet().
+    Error_t get_feature_set_finish(std::uint16_t &featureSet)
+        {
+        auto result = this->getAsyncResponse<Command_t::get_feature_set_version>(featureSet);
+        if (isSuccess(result))
+            result = this->setFeatureSet(featureSet);
+        return result;
+        }
+
+    /// \brief Get the cached feature-set version; zero if not known or not supported.
+    std::uint8_t getFeatureSet() const
+        {
+        return this->m_featureSet;
+        }
+
+    /// \brief Get the current TVOC baseline from the sensor.
+    ///
+    /// \param result [out]     Set to the baseline; save this (for example,
+    ///                         hourly) and pass it to begin() after a restart.
+    Error_t get_tvoc_baseline_synchronous(std::uint16_t &result)
+        {
+        return this->sendAndGetSynchronous<Command_t::get_tvoc_baseline>(result);
+        }
+
+    /// \brief Restore a previously-saved TVOC baseline.
+    Error_t set_tvoc_baseline_synchronous(std::uint16_t baseline)
+        {
+        return this->sendSynchronous<Command_t::set_tvoc_baseline>(baseline);
+        }
+
+    /// \brief Get the time between measurement updates for the current power mode.
+    Millisecond_t getMeasurementPeriodMs() const
+        {
+        return this->m_powerMode == PowerMode_t::UltraLow ? kTultraLowPowerMs : kTlowPowerMs;
+        }
+
+    /// \brief Test whether measurement data is considered valid.
+    ///
+    /// \param tNow [in]    The current time; defaults to \c millis().
+    ///
+    /// \details
+    ///     Data is invalid until continuous mode has been started, and then
+    ///     until the preheat period (or, without preheat, the first measurement
+    ///     period) has elapsed. A chip reset makes data invalid again.
+    bool isDataValid(Millisecond_t tNow = millis()) const
+        {
+        return this->m_fStarted && std::int32_t(tNow - this->m_tDataValid) >= 0;
+        }
+
+    /// \brief Get the time (in \c millis()) when data will be valid.
+    ///
+    /// \details
+    ///     The result is only meaningful once continuous mode has been started.
+    Millisecond_t getDataValidTime() const
+        {
+        return this->m_tDataValid;
+        }
+
     /// \brief Get a TVOC measurement
     ///
     /// \param result [out]     Set to the TVOC in ppb (0 to 60000).
@@ -521,6 +1137,50 @@ public:
         return this->sendAndGetSynchronous<Command_t::measure_tvoc>(result);
         }
 
+    /// \brief Get a raw signal measurement
+    ///
+    /// \param result [out]     Set to the raw signal, in sensor ticks.
+    Error_t measure_raw_synchronous(std::uint16_t &result)
+        {
+        return this->sendAndGetSynchronous<Command_t::measure_raw>(result);
+        }
+
+    /// \brief Get a TVOC and a raw signal measurement in one command
+    ///
+    /// \param tvoc [out]       Set to the TVOC in ppb (0 to 60000).
+    /// \param raw [out]        Set to the raw signal, in sensor ticks.
+    Error_t measure_tvoc_and_raw_synchronous(std::uint16_t &tvoc, std::uint16_t &raw)
+        {
+        return this->sendAndGetSynchronous<Command_t::measure_tvoc_and_raw>(tvoc, raw);
+        }
+
+    /// \brief Get a TVOC measurement, returned by value with metadata.
+    Measurement_t measure_tvoc()
+        {
+        std::uint16_t tvoc = 0;
+        auto const tCall = millis();
+        auto const e = this->measure_tvoc_synchronous(tvoc);
+        return this->makeMeasurement(Command_t::measure_tvoc, tCall, e, tvoc, 0);
+        }
+
+    /// \brief Get a raw signal measurement, returned by value with metadata.
+    Measurement_t measure_raw()
+        {
+        std::uint16_t raw = 0;
+        auto const tCall = millis();
+        auto const e = this->measure_raw_synchronous(raw);
+        return this->makeMeasurement(Command_t::measure_raw, tCall, e, 0, raw);
+        }
+
+    /// \brief Get a TVOC and raw signal measurement, returned by value with metadata.
+    Measurement_t measure_tvoc_and_raw()
+        {
+        std::uint16_t tvoc = 0, raw = 0;
+        auto const tCall = millis();
+        auto const e = this->measure_tvoc_and_raw_synchronous(tvoc, raw);
+        return this->makeMeasurement(Command_t::measure_tvoc_and_raw, tCall, e, tvoc, raw);
+        }
+
     /// \brief Set the power-consumption level of the sensor.
     ///
     /// \param [in] mode    The target power mode.
@@ -545,6 +1205,11 @@ public:
         {
         this->m_powerMode = PowerMode_t::Low;
         this->m_tAvail = when + kTpuMs;
+        this->m_fStarted = false;
+        this->m_fPending = false;
+
+        for (auto pObserver = this->m_pObservers; pObserver != nullptr; pObserver = pObserver->m_pNext)
+            pObserver->onChipReset(when);
         }
 
 private:
@@ -567,20 +1232,59 @@ private:
             return Error_t::Success;
         }
 
+    /// \brief Record that continuous mode has started, and when data will be valid.
+    /// \param delayMs [in] Time (in milliseconds) from now until data is valid.
+    void setDataValidTime(Millisecond_t delayMs)
+        {
+        this->m_fStarted = true;
+        this->m_tStarted = millis();
+        this->m_tDataValid = this->m_tStarted + delayMs;
+        // update 0 means "no output yet".
+        this->m_lastUpdate = 0;
+        }
+
+    /// \brief Build a measurement result from the most recent command.
+    Measurement_t makeMeasurement(Command_t c, Millisecond_t tCall, Error_t e, std::uint16_t tvoc, std::uint16_t raw);
+
     /// \brief Calculate the Sensirion CRC over a bufffer.
     static std::uint8_t crc(const std::uint8_t * buf, size_t nBuf, std::uint8_t crc8 = 0xFF);
 
 private:
     /// \brief the I2C bus to use for communication.
     TwoWire *m_wire;
+    /// \brief head of the list of observers.
+    cObserver *m_pObservers;
     /// \brief the current power mode.
     PowerMode_t m_powerMode;
     /// \brief The time, in `millis()`, when the sensor will be available again.
     Millisecond_t m_tAvail;
+    /// \brief The time, in `millis()`, when measurement data will be valid.
+    Millisecond_t m_tDataValid;
+    /// \brief The time, in `millis()`, when continuous measurement was started.
+    Millisecond_t m_tStarted;
+    /// \brief Index (in sensor periods since start) of the last update read.
+    std::uint32_t m_lastUpdate;
     /// \brief The feature set byte; 0 if chip not recognized or not initialized.
     std::uint8_t m_featureSet;
+    /// \brief Set true when continuous measurement has been started.
+    bool m_fStarted;
+    /// \brief Set true while a command started by startCommand() awaits finishCommand().
+    bool m_fPending;
+    /// \brief The command in progress, or most recently completed.
+    Transaction_t m_pending;
     };
 
+static_assert(offsetof(cSGPC3::Measurement_t, tCapture) == 0 &&
+              offsetof(cSGPC3::Measurement_t, tvoc) == 4 &&
+              offsetof(cSGPC3::Measurement_t, raw) == 6 &&
+              offsetof(cSGPC3::Measurement_t, ageMs) == 8 &&
+              offsetof(cSGPC3::Measurement_t, command) == 10 &&
+              offsetof(cSGPC3::Measurement_t, error) == 12 &&
+              offsetof(cSGPC3::Measurement_t, flags) == 13 &&
+              offsetof(cSGPC3::Measurement_t, reserved) == 14 &&
+              sizeof(cSGPC3::Measurement_t) == 16,
+              "Measurement_t layout has padding");
+
 // end group scpc3
 /// \}
 
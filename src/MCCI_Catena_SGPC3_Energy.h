@@ -0,0 +1,227 @@
+/*
+
+Module: MCCI_Catena_SGPC3_Energy.h
+
+Function:
+    Energy-estimation model for the Catena SGPC3 library.
+
+Copyright and License:
+    See accompanying LICENSE file.
+
+Author:
+    Terry Moore, MCCI Corporation   May 2020
+
+*/
+
+#ifndef _MCCI_Catena_SGPC3_Energy_h_
+# define _MCCI_Catena_SGPC3_Energy_h_
+# pragma once
+
+/// \file
+
+#include "MCCI_Catena_SGPC3.h"
+
+namespace McciCatenaSGPC3 {
+
+/// \defgroup energy Energy accounting
+/// \{
+
+/*!
+
+\brief Estimate the energy used by an SGPC3 sensor.
+
+\details
+    An instance of this class is attached to a sensor using
+    cSGPC3::addObserver(), normally before cSGPC3::begin(); if it's attached
+    later, seed the state with reset(when, initial, mode), or it will
+    assume that the chip is idle. It then sees every command sent to the sensor,
+    and accumulates an estimate of the energy used, in picojoules. The
+    estimate has three parts:
+
+    - the background consumption of the sensor, which depends on whether
+      it has been started with `tvoc_init_continuous`, and on the power
+      mode;
+    - the incremental consumption while the sensor executes a command,
+      for the command delay from the datasheet; and
+    - the consumption while bytes are being transferred on the bus,
+      using cSGPC3::getBusTimeUs().
+
+    The model uses only the information in each cSGPC3::Transaction_t,
+    so it can be driven on a host from a recorded trace by calling
+    onChipReset() and onTransaction() directly, followed by
+    accumulateTo(). This allows scheduling strategies to be compared
+    before they're deployed.
+
+*/
+class cSGPC3_EnergyModel : public cSGPC3_cmds, public cSGPC3::cObserver
+    {
+public:
+    using Millisecond_t = cSGPC3::Millisecond_t;
+    using PowerMode_t = cSGPC3::PowerMode_t;
+
+    /// \brief Supply voltage and currents used by the model.
+    ///
+    /// \details
+    ///     Currents are in microamps, voltage is in millivolts.
+    struct Parameters_t
+        {
+        std::uint16_t mvSupply;     ///< Supply voltage.
+        std::uint16_t uaIdle;       ///< Average current before continuous mode is started.
+        std::uint16_t uaUltraLow;   ///< Average current in ultra-low-power mode.
+        std::uint16_t uaLow;        ///< Average current in low-power mode.
+        std::uint16_t uaCommand;    ///< Additional current while executing a command.
+        std::uint16_t uaTest;       ///< Additional current while executing `measure_test`.
+        std::uint16_t uaBus;        ///< Additional current (including pull-ups) while transferring data.
+        };
+
+    /// \brief Nominal parameters, based on the SGPC3 datasheet at 1.8 V.
+    ///
+    /// \details
+    ///     These are typical figures; for accurate battery sizing, measure
+    ///     your own board and pass the results to the constructor.
+    static constexpr Parameters_t kDefaultParameters =
+        {
+        /* mvSupply */   1800,
+        /* uaIdle */       34,
+        /* uaUltraLow */   65,
+        /* uaLow */       390,
+        /* uaCommand */   400,
+        /* uaTest */     2800,
+        /* uaBus */       200,
+        };
+
+    /// \brief Number of distinct commands tracked.
+    static constexpr unsigned kNumCommands = 13;
+
+    /// \brief Background states tracked.
+    enum class State_t : std::uint8_t
+        {
+        Idle,                       ///< Continuous mode not started.
+        UltraLow,                   ///< Running in ultra-low-power mode.
+        Low,                        ///< Running in low-power mode.
+        nStates                     ///< Number of states.
+        };
+
+    /// \brief Per-command statistics.
+    struct CommandStats_t
+        {
+        std::uint32_t count;        ///< Number of times the command was sent.
+        std::uint64_t picojoules;   ///< Energy charged to the command (execution and bus).
+        };
+
+    /// \brief Construct an energy model.
+    /// \param params [in]  The supply voltage and currents to be used.
+    cSGPC3_EnergyModel(const Parameters_t &params = kDefaultParameters)
+        : m_params(params)
+        {
+        this->reset(0);
+        }
+
+    /// \brief Clear all accumulated energy, and assume an idle chip.
+    /// \param when [in]    The time (in \c millis()) at which accounting starts.
+    void reset(Millisecond_t when)
+        {
+        this->reset(when, State_t::Idle, PowerMode_t::Low);
+        }
+
+    /// \brief Clear all accumulated energy, and assume a given starting state.
+    ///
+    /// \param when [in]    The time (in \c millis()) at which accounting starts.
+    /// \param initial [in] The background state at \p when.
+    /// \param mode [in]    The power mode that has been set in the chip.
+    ///
+    /// \details
+    ///     Use this when the model is attached to a sensor that is already
+    ///     running (after cSGPC3::begin()), or to drive it from a trace that
+    ///     doesn't include the start of continuous mode.
+    void reset(Millisecond_t when, State_t initial, PowerMode_t mode);
+
+    virtual void onTransaction(const cSGPC3::Transaction_t &t) override;
+    virtual void onChipReset(Millisecond_t when) override;
+
+    /// \brief Charge background energy up to a given time.
+    ///
+    /// \param tNow [in]    The time (in \c millis()) to account up to. Call this
+    ///                     before querying totals at run time.
+    void accumulateTo(Millisecond_t tNow);
+
+    /// \brief Get the total estimated energy, in picojoules.
+    std::uint64_t getTotalPicojoules() const;
+
+    /// \brief Get the total estimated energy, in microjoules.
+    std::uint64_t getTotalMicrojoules() const
+        {
+        return this->getTotalPicojoules() / 1000000u;
+        }
+
+    /// \brief Get the background energy charged to a given state, in picojoules.
+    std::uint64_t getStatePicojoules(State_t s) const
+        {
+        return s < State_t::nStates ? this->m_statePj[unsigned(s)] : 0;
+        }
+
+    /// \brief Get the time accounted to a given state, in milliseconds.
+    std::uint32_t getStateMs(State_t s) const
+        {
+        return s < State_t::nStates ? this->m_stateMs[unsigned(s)] : 0;
+        }
+
+    /// \brief Get statistics for a given command index.
+    /// \param iCommand [in]    Index in `[0, kNumCommands)`; see getCommandName().
+    const CommandStats_t *getCommandStats(unsigned iCommand) const
+        {
+        return iCommand < kNumCommands ? &this->m_commandStats[iCommand] : nullptr;
+        }
+
+    /// \brief Get the name of a given command index, for reports.
+    static const char *getCommandName(unsigned iCommand);
+
+    /// \brief Get the current background state.
+    State_t getState() const
+        {
+        return this->m_state;
+        }
+
+private:
+    /// \brief Map a command to an index in `[0, kNumCommands)`.
+    static unsigned getCommandIndex(Command_t c);
+
+    /// \brief Compute energy in picojoules for a current and duration in microseconds.
+    std::uint64_t picojoulesFromUs(std::uint16_t ua, std::uint32_t us) const
+        {
+        // uA * mV * us == 1e-15 J.
+        return (std::uint64_t(ua) * this->m_params.mvSupply * us) / 1000u;
+        }
+
+    /// \brief Compute energy in picojoules for a current and duration in milliseconds.
+    std::uint64_t picojoulesFromMs(std::uint16_t ua, std::uint32_t ms) const
+        {
+        // uA * mV * ms == 1e-12 J.
+        return std::uint64_t(ua) * this->m_params.mvSupply * ms;
+        }
+
+    /// \brief Get the background current for a state.
+    std::uint16_t getStateCurrent(State_t s) const;
+
+    /// \brief The model parameters.
+    Parameters_t m_params;
+    /// \brief The time through which background energy has been charged.
+    Millisecond_t m_tLast;
+    /// \brief The current background state.
+    State_t m_state;
+    /// \brief Power mode that will be used when continuous mode is started.
+    PowerMode_t m_powerMode;
+    /// \brief Background energy, by state.
+    std::uint64_t m_statePj[unsigned(State_t::nStates)];
+    /// \brief Background time, by state.
+    std::uint32_t m_stateMs[unsigned(State_t::nStates)];
+    /// \brief Per-command statistics.
+    CommandStats_t m_commandStats[kNumCommands];
+    };
+
+// end group energy
+/// \}
+
+} // McciCatenaSGPC3
+
+#endif // _MCCI_Catena_SGPC3_Energy_h_
@@ -0,0 +1,384 @@
+/*
+
+Module: MCCI_Catena_SGPC3_Filter.h
+
+Function:
+    Streaming filter stages for TVOC and raw signals from the SGPC3.
+
+Copyright and License:
+    See accompanying LICENSE file.
+
+Author:
+    Terry Moore, MCCI Corporation   May 2020
+
+*/
+
+#ifndef _MCCI_Catena_SGPC3_Filter_h_
+# define _MCCI_Catena_SGPC3_Filter_h_
+# pragma once
+
+/// \file
+
+#include "MCCI_Catena_SGPC3.h"
+
+namespace McciCatenaSGPC3 {
+
+/// \defgroup filter Streaming filters
+///
+/// \details
+///     These classes filter streams of 16-bit samples (TVOC in ppb, or raw
+///     signal ticks) on the node, before they're stored or transmitted.
+///     All arithmetic is integer, memory is fixed at compile time by the
+///     window size, and nothing is allocated.
+///
+///     Each stage provides `bool put(Sample_t in, Sample_t &out)`, which
+///     consumes one sample, and returns \c true (and sets \p out) if the
+///     stage produced a sample. Stages are combined with \ref cFilterPipeline.
+///     Each stage also provides `reset()`, which should be called after the
+///     sensor is restarted.
+/// \{
+
+/// \brief The type of samples processed by the filter stages.
+using Sample_t = std::uint16_t;
+
+/// \brief A window of the most recent samples, kept in arrival and sorted order.
+///
+/// \tparam N   The window size.
+///
+/// \details
+///     Adding a sample costs O(N); the median and the median absolute deviation
+///     can then be found in O(1) and O(N) respectively.
+template <unsigned N>
+class cSortedWindow
+    {
+    static_assert(N >= 1 && N <= 255, "window size must be in [1, 255]");
+
+public:
+    cSortedWindow()
+        {
+        this->reset();
+        }
+
+    /// \brief Discard all samples.
+    void reset()
+        {
+        this->m_nSamples = 0;
+        this->m_iNext = 0;
+        }
+
+    /// \brief Return the number of samples in the window.
+    unsigned size() const
+        {
+        return this->m_nSamples;
+        }
+
+    /// \brief Test whether the window is full.
+    bool isFull() const
+        {
+        return this->m_nSamples == N;
+        }
+
+    /// \brief Add a sample, discarding the oldest if the window is full.
+    void push(Sample_t v)
+        {
+        unsigned i;
+
+        if (this->m_nSamples == N)
+            {
+            // remove the oldest sample from the sorted array.
+            Sample_t const vOld = this->m_ring[this->m_iNext];
+
+            for (i = 0; this->m_sorted[i] != vOld; ++i)
+                /* loop */;
+            for (; i + 1 < N; ++i)
+                this->m_sorted[i] = this->m_sorted[i + 1];
+            }
+        else
+            ++this->m_nSamples;
+
+        this->m_ring[this->m_iNext] = v;
+        if (++this->m_iNext == N)
+            this->m_iNext = 0;
+
+        // insert the new sample in the sorted array.
+        for (i = this->m_nSamples - 1; i > 0 && this->m_sorted[i - 1] > v; --i)
+            this->m_sorted[i] = this->m_sorted[i - 1];
+        this->m_sorted[i] = v;
+        }
+
+    /// \brief Return the median of the window (the lower median, if the count is even).
+    Sample_t median() const
+        {
+        return this->m_nSamples == 0 ? 0 : this->m_sorted[(this->m_nSamples - 1) / 2];
+        }
+
+    /// \brief Return the median absolute deviation from the median.
+    ///
+    /// \details
+    ///     The deviations from the median are already in order if we walk outward
+    ///     from the median in both directions, so we merge the two sequences
+    ///     until we reach the middle element.
+    Sample_t mad() const
+        {
+        if (this->m_nSamples == 0)
+            return 0;
+
+        unsigned const iMedian = (this->m_nSamples - 1) / 2;
+        Sample_t const m = this->m_sorted[iMedian];
+        int iLow = int(iMedian) - 1;
+        unsigned iHigh = iMedian + 1;
+        Sample_t d = 0;
+
+        // the median itself contributes the first (zero) deviation.
+        for (unsigned k = 1; k <= iMedian; ++k)
+            {
+            Sample_t const dLow = iLow >= 0 ? Sample_t(m - this->m_sorted[iLow]) : Sample_t(~0u);
+            Sample_t const dHigh = iHigh < this->m_nSamples ? Sample_t(this->m_sorted[iHigh] - m) : Sample_t(~0u);
+
+            if (dLow <= dHigh)
+                {
+                d = dLow;
+                --iLow;
+                }
+            else
+                {
+                d = dHigh;
+                ++iHigh;
+                }
+            }
+
+        return d;
+        }
+
+private:
+    /// \brief Samples in arrival order.
+    Sample_t m_ring[N];
+    /// \brief Samples in ascending order.
+    Sample_t m_sorted[N];
+    /// \brief Number of valid samples.
+    std::uint8_t m_nSamples;
+    /// \brief Index in \c m_ring of the next slot to be written.
+    std::uint8_t m_iNext;
+    };
+
+/// \brief Running median filter.
+///
+/// \tparam N   The window size; odd values are recommended.
+///
+/// \details
+///     Every input produces an output: the median of the last \p N samples
+///     (or of all samples so far, while the window is filling).
+template <unsigned N>
+class cMedianFilter
+    {
+public:
+    void reset()
+        {
+        this->m_window.reset();
+        }
+
+    bool put(Sample_t in, Sample_t &out)
+        {
+        this->m_window.push(in);
+        out = this->m_window.median();
+        return true;
+        }
+
+private:
+    cSortedWindow<N> m_window;
+    };
+
+/// \brief Hampel-style outlier rejector.
+///
+/// \tparam N   The window size; odd values are recommended.
+///
+/// \details
+///     Each sample is added to the window, and then compared to the median
+///     of the window. If it differs from the median by more than a threshold,
+///     it is replaced by the median. The threshold is the larger of a fixed
+///     minimum, and a multiple of the scaled median absolute deviation (MAD
+///     times 1.4826, an estimate of the standard deviation). Until at least
+///     three samples have been seen, samples are passed through.
+template <unsigned N>
+class cHampelFilter
+    {
+public:
+    /// \brief Construct a Hampel filter.
+    ///
+    /// \param nSigmaX10 [in]       Threshold, in tenths of a standard deviation.
+    ///                             The default (30) is the usual three sigma.
+    /// \param minDeviation [in]    Deviations up to this value are never rejected.
+    ///                             This prevents rejection of normal noise when
+    ///                             the signal is flat and the MAD is zero.
+    cHampelFilter(std::uint8_t nSigmaX10 = 30, Sample_t minDeviation = 1)
+        : m_nSigmaX10(nSigmaX10)
+        , m_minDeviation(minDeviation)
+        , m_nRejected(0)
+        {}
+
+    void reset()
+        {
+        this->m_window.reset();
+        }
+
+    bool put(Sample_t in, Sample_t &out)
+        {
+        this->m_window.push(in);
+        out = in;
+
+        if (this->m_window.size() < 3)
+            return true;
+
+        Sample_t const m = this->m_window.median();
+        std::uint32_t const dev = in > m ? in - m : m - in;
+
+        if (dev <= this->m_minDeviation)
+            return true;
+
+        // dev > nSigma * 1.4826 * MAD, scaled by 10000; the right-hand
+        // side can exceed 32 bits for raw signals.
+        if (std::uint64_t(dev) * 10000u > std::uint64_t(this->m_nSigmaX10) * 1483u * this->m_window.mad())
+            {
+            out = m;
+            ++this->m_nRejected;
+            }
+
+        return true;
+        }
+
+    /// \brief Return the number of samples rejected so far.
+    std::uint32_t getRejectedCount() const
+        {
+        return this->m_nRejected;
+        }
+
+private:
+    cSortedWindow<N> m_window;
+    std::uint8_t m_nSigmaX10;
+    Sample_t m_minDeviation;
+    std::uint32_t m_nRejected;
+    };
+
+/// \brief N:1 decimator.
+///
+/// \tparam N   The decimation ratio.
+///
+/// \details
+///     Every \p N inputs produce one output, the rounded mean of the inputs.
+template <unsigned N>
+class cDecimator
+    {
+    static_assert(N >= 1 && N <= 65535, "decimation ratio must be in [1, 65535]");
+
+public:
+    cDecimator()
+        {
+        this->reset();
+        }
+
+    void reset()
+        {
+        this->m_sum = 0;
+        this->m_count = 0;
+        }
+
+    bool put(Sample_t in, Sample_t &out)
+        {
+        this->m_sum += in;
+        if (++this->m_count < N)
+            return false;
+
+        out = Sample_t((this->m_sum + N / 2) / N);
+        this->reset();
+        return true;
+        }
+
+private:
+    std::uint32_t m_sum;
+    std::uint16_t m_count;
+    };
+
+/// \brief A pipeline of filter stages.
+///
+/// \tparam TStages The stages, in the order in which samples pass through them.
+///
+/// \details
+///     For example, to remove spikes from TVOC readings taken every two seconds
+///     and report one value a minute:
+///
+///     ```c++
+///     cFilterPipeline<cHampelFilter<7>, cMedianFilter<5>, cDecimator<30>> gTvocFilter;
+///     ```
+///
+///     Individual stages can be reached with getStage() (for example to read
+///     statistics, or to replace a stage with one constructed with non-default
+///     parameters).
+template <typename... TStages>
+class cFilterPipeline;
+
+/// \brief Empty pipeline: passes samples through unchanged.
+template <>
+class cFilterPipeline<>
+    {
+public:
+    void reset()
+        {}
+
+    bool put(Sample_t in, Sample_t &out)
+        {
+        out = in;
+        return true;
+        }
+    };
+
+/// \brief Pipeline of one or more stages.
+template <typename TFirst, typename... TRest>
+class cFilterPipeline<TFirst, TRest...>
+    {
+public:
+    /// \brief Reset all stages.
+    void reset()
+        {
+        this->m_first.reset();
+        this->m_rest.reset();
+        }
+
+    /// \brief Process one sample.
+    ///
+    /// \param in [in]      The input sample.
+    /// \param out [out]    Set to the output, if the pipeline produced one.
+    ///
+    /// \returns \c true if a sample was produced.
+    bool put(Sample_t in, Sample_t &out)
+        {
+        Sample_t v;
+
+        if (! this->m_first.put(in, v))
+            return false;
+
+        return this->m_rest.put(v, out);
+        }
+
+    /// \brief Get the first stage.
+    TFirst &getStage()
+        {
+        return this->m_first;
+        }
+
+    /// \brief Get the pipeline of remaining stages.
+    cFilterPipeline<TRest...> &getRest()
+        {
+        return this->m_rest;
+        }
+
+private:
+    TFirst m_first;
+    cFilterPipeline<TRest...> m_rest;
+    };
+
+// end group filter
+/// \}
+
+} // McciCatenaSGPC3
+
+#endif // _MCCI_Catena_SGPC3_Filter_h_
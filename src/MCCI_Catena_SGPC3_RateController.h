@@ -0,0 +1,165 @@
+/*
+
+Module: MCCI_Catena_SGPC3_RateController.h
+
+Function:
+    Adaptive host read-rate controller for the Catena SGPC3 library.
+
+Copyright and License:
+    See accompanying LICENSE file.
+
+Author:
+    Terry Moore, MCCI Corporation   May 2020
+
+*/
+
+#ifndef _MCCI_Catena_SGPC3_RateController_h_
+# define _MCCI_Catena_SGPC3_RateController_h_
+# pragma once
+
+/// \file
+
+#include "MCCI_Catena_SGPC3.h"
+
+namespace McciCatenaSGPC3 {
+
+/// \defgroup ratecontroller Adaptive read rate
+/// \{
+
+/*!
+
+\brief Adapt how often the host reads an SGPC3 to the activity of the signal.
+
+\details
+    Sensirion advises against switching the power mode of a running sensor,
+    so the sensor keeps updating at its fixed rate (every 2 s in low-power
+    mode). This controller changes only how often the *host* reads it.
+
+    After each read, the controller looks at the rate of change since the
+    previous read, and at the variance of the last few reads. When both are
+    small, the read interval is doubled, up to a maximum number of sensor
+    periods. As soon as the rate of change or the variance shows activity,
+    the interval drops back to one sensor period. Fewer reads mean fewer
+    host wakeups, less I2C traffic, and fewer samples to send.
+
+    Call poll() from the main loop; it reads the sensor only when a read is
+    due. Alternatively, read the sensor yourself when isReadDue() is true,
+    and pass the result to update().
+
+*/
+class cSGPC3_RateController
+    {
+public:
+    using Millisecond_t = cSGPC3::Millisecond_t;
+    using Error_t = cSGPC3::Error_t;
+
+    /// \brief Number of recent samples used for the variance.
+    static constexpr unsigned kWindow = 8;
+
+    /// \brief Tuning parameters. Values are in ppb.
+    struct Config_t
+        {
+        std::uint16_t flatRate;         ///< Change per sensor period at or below which the signal is flat.
+        std::uint16_t activityRate;     ///< Change per sensor period above which the signal is active.
+        std::uint16_t activityStep;     ///< Change since the last read above which the signal is active.
+        std::uint32_t flatVariance;     ///< Window variance (ppb squared) at or below which the signal is flat.
+        std::uint8_t maxDivider;        ///< Maximum interval, in sensor periods (a power of two).
+        };
+
+    /// \brief Default tuning.
+    static constexpr Config_t kDefaultConfig =
+        {
+        /* flatRate */      1,
+        /* activityRate */  5,
+        /* activityStep */  25,
+        /* flatVariance */  4,
+        /* maxDivider */    16,
+        };
+
+    /// \brief Construct a controller for a sensor.
+    cSGPC3_RateController(cSGPC3 &sensor, const Config_t &config = kDefaultConfig)
+        : m_pSensor(&sensor)
+        , m_config(config)
+        {
+        this->reset();
+        }
+
+    /// \brief Forget history and go back to reading every sensor period.
+    void reset();
+
+    /// \brief Read the sensor if a read is due.
+    ///
+    /// \param tvoc [out]   Set to the TVOC in ppb, if a read was made.
+    /// \param tNow [in]    The current time.
+    ///
+    /// \returns \c true if a read was made and succeeded.
+    bool poll(std::uint16_t &tvoc, Millisecond_t tNow = millis());
+
+    /// \brief Test whether a read is due.
+    bool isReadDue(Millisecond_t tNow = millis()) const
+        {
+        return this->m_pSensor->isDataValid(tNow) &&
+               std::int32_t(tNow - this->m_tNext) >= 0;
+        }
+
+    /// \brief Get the time (in \c millis()) when the next read is due.
+    ///
+    /// \details
+    ///     Useful for deciding how long to sleep. If the sensor's data is not yet
+    ///     valid, the result is no earlier than cSGPC3::getDataValidTime().
+    Millisecond_t getNextReadTime() const;
+
+    /// \brief Account for a sample read by the caller.
+    ///
+    /// \param tvoc [in]    The sample.
+    /// \param tRead [in]   When it was read.
+    void update(std::uint16_t tvoc, Millisecond_t tRead);
+
+    /// \brief Get the current read interval, in sensor periods.
+    std::uint8_t getDivider() const
+        {
+        return this->m_divider;
+        }
+
+    /// \brief Get the number of reads made.
+    std::uint32_t getReadCount() const
+        {
+        return this->m_nReads;
+        }
+
+    /// \brief Get the number of sensor periods that were not read.
+    std::uint32_t getSkippedCount() const
+        {
+        return this->m_nSkipped;
+        }
+
+private:
+    /// \brief Compute the variance of the window, in ppb squared.
+    std::uint32_t getVariance() const;
+
+    cSGPC3 *m_pSensor;
+    Config_t m_config;
+    /// \brief Recent samples, oldest overwritten first.
+    std::uint16_t m_window[kWindow];
+    /// \brief Number of valid samples in \c m_window.
+    std::uint8_t m_nWindow;
+    /// \brief Index of next slot in \c m_window.
+    std::uint8_t m_iWindow;
+    /// \brief Current interval, in sensor periods.
+    std::uint8_t m_divider;
+    /// \brief The previous sample.
+    std::uint16_t m_last;
+    /// \brief The time of the previous sample.
+    Millisecond_t m_tLast;
+    /// \brief The time of the next read.
+    Millisecond_t m_tNext;
+    std::uint32_t m_nReads;
+    std::uint32_t m_nSkipped;
+    };
+
+// end group ratecontroller
+/// \}
+
+} // McciCatenaSGPC3
+
+#endif // _MCCI_Catena_SGPC3_RateController_h_
@@ -0,0 +1,207 @@
+/*
+
+Module: MCCI_Catena_SGPC3_Registry.h
+
+Function:
+    Registry of SGPC3 sensors, identified by serial ID in one pass.
+
+Copyright and License:
+    See accompanying LICENSE file.
+
+Author:
+    Terry Moore, MCCI Corporation   May 2020
+
+*/
+
+#ifndef _MCCI_Catena_SGPC3_Registry_h_
+# define _MCCI_Catena_SGPC3_Registry_h_
+# pragma once
+
+/// \file
+
+#include "MCCI_Catena_SGPC3.h"
+
+namespace McciCatenaSGPC3 {
+
+/// \defgroup registry Device registry
+/// \{
+
+/*!
+
+\brief Registry of the SGPC3 sensors attached to a node.
+
+\tparam TCalibration    The client's per-sensor calibration data.
+\tparam N               The maximum number of sensors.
+
+\details
+    Each physical sensor is identified by its 48-bit serial ID. At boot,
+    the client adds each \ref cSGPC3 instance and calls scan(). The
+    scan starts the feature-set query on every sensor before waiting for
+    any of them, then does the same for the serial ID, so the command
+    delays overlap: identifying N sensors costs one set of delays, plus
+    the bus time for each sensor.
+
+    The SGPC3 has a fixed I2C address (0x58), so this only works if each
+    sensor is on its own \c TwoWire; two sensors can't share a bus
+    without a mux, and the registry doesn't select mux channels.
+
+    Each entry caches the identity, together with a calibration slot and
+    a baseline slot. These are filled in by a loader function supplied to
+    scan(), typically from non-volatile storage keyed by serial ID. The
+    baseline slot can be passed straight to cSGPC3::begin().
+
+*/
+template <typename TCalibration, unsigned N>
+class cSGPC3_Registry
+    {
+public:
+    using Error_t = cSGPC3::Error_t;
+
+    /// \brief Information cached for each sensor.
+    struct Entry_t
+        {
+        cSGPC3 *pSensor;                ///< The sensor instance.
+        std::uint64_t serialId;         ///< The 48-bit serial ID (valid if status is Success).
+        std::uint16_t featureSet;       ///< The raw feature-set word (valid if status is Success).
+        Error_t status;                 ///< Result of identification.
+        bool fCalibration;              ///< True if \c calibration was loaded.
+        bool fBaseline;                 ///< True if \c baseline was loaded.
+        TCalibration calibration;       ///< The calibration slot.
+        cSGPC3::Baseline_t baseline;    ///< The baseline slot.
+
+        /// \brief Return a pointer to the baseline, or \c nullptr if none; suitable for cSGPC3::begin().
+        const cSGPC3::Baseline_t *getBaseline() const
+            {
+            return this->fBaseline ? &this->baseline : nullptr;
+            }
+        };
+
+    /// \brief Function that fills in calibration and baseline slots for a serial ID.
+    ///
+    /// \details
+    ///     The function reports which slots it filled by setting
+    ///     \c fCalibration and \c fBaseline in the entry.
+    using Loader_t = void (*)(Entry_t &entry, void *pClientData);
+
+    cSGPC3_Registry()
+        : m_nEntries(0)
+        {}
+
+    /// \brief Add a sensor to the registry.
+    ///
+    /// \returns \c false if the registry is full.
+    bool add(cSGPC3 &sensor)
+        {
+        if (this->m_nEntries >= N)
+            return false;
+
+        auto &entry = this->m_entries[this->m_nEntries++];
+        entry.pSensor = &sensor;
+        entry.serialId = 0;
+        entry.featureSet = 0;
+        entry.status = Error_t::Failure;
+        entry.fCalibration = false;
+        entry.fBaseline = false;
+        return true;
+        }
+
+    /// \brief Identify all sensors in one interleaved pass.
+    ///
+    /// \param pLoader [in]     Function to fill in calibration and baseline
+    ///                         slots for each identified sensor, or \c nullptr.
+    /// \param pClientData [in] Passed to \p pLoader.
+    ///
+    /// \returns the number of sensors identified.
+    ///
+    /// \details
+    ///     The feature set must be read first, because the driver only sends
+    ///     `get_serial_id` to sensors with a known feature set.
+    unsigned scan(Loader_t pLoader = nullptr, void *pClientData = nullptr)
+        {
+        unsigned nIdentified = 0;
+
+        // phase 1: feature set.
+        for (unsigned i = 0; i < this->m_nEntries; ++i)
+            this->m_entries[i].status = this->m_entries[i].pSensor->get_feature_set_start();
+
+        for (unsigned i = 0; i < this->m_nEntries; ++i)
+            {
+            auto &entry = this->m_entries[i];
+            if (cSGPC3::isSuccess(entry.status))
+                entry.status = entry.pSensor->get_feature_set_finish(entry.featureSet);
+            }
+
+        // phase 2: serial ID.
+        for (unsigned i = 0; i < this->m_nEntries; ++i)
+            {
+            auto &entry = this->m_entries[i];
+            if (cSGPC3::isSuccess(entry.status))
+                entry.status = entry.pSensor->get_serial_id_start();
+            }
+
+        for (unsigned i = 0; i < this->m_nEntries; ++i)
+            {
+            auto &entry = this->m_entries[i];
+            if (! cSGPC3::isSuccess(entry.status))
+                continue;
+
+            entry.status = entry.pSensor->get_serial_id_finish(entry.serialId);
+            if (! cSGPC3::isSuccess(entry.status))
+                continue;
+
+            ++nIdentified;
+            entry.fCalibration = false;
+            entry.fBaseline = false;
+            if (pLoader != nullptr)
+                pLoader(entry, pClientData);
+            }
+
+        return nIdentified;
+        }
+
+    /// \brief Return the number of sensors in the registry.
+    unsigned size() const
+        {
+        return this->m_nEntries;
+        }
+
+    /// \brief Return an entry by index, or \c nullptr.
+    Entry_t *getEntry(unsigned i)
+        {
+        return i < this->m_nEntries ? &this->m_entries[i] : nullptr;
+        }
+
+    /// \brief Find the entry for an identified serial ID, or \c nullptr.
+    Entry_t *find(std::uint64_t serialId)
+        {
+        for (unsigned i = 0; i < this->m_nEntries; ++i)
+            {
+            auto &entry = this->m_entries[i];
+            if (cSGPC3::isSuccess(entry.status) && entry.serialId == serialId)
+                return &entry;
+            }
+        return nullptr;
+        }
+
+    /// \brief Find the entry for a sensor instance, or \c nullptr.
+    Entry_t *find(const cSGPC3 &sensor)
+        {
+        for (unsigned i = 0; i < this->m_nEntries; ++i)
+            {
+            if (this->m_entries[i].pSensor == &sensor)
+                return &this->m_entries[i];
+            }
+        return nullptr;
+        }
+
+private:
+    Entry_t m_entries[N];
+    unsigned m_nEntries;
+    };
+
+// end group registry
+/// \}
+
+} // McciCatenaSGPC3
+
+#endif // _MCCI_Catena_SGPC3_Registry_h_
@@ -0,0 +1,201 @@
+/*
+
+Module: MCCI_Catena_SGPC3_Trace.h
+
+Function:
+    Bus-transaction trace recorder for the Catena SGPC3 library.
+
+Copyright and License:
+    See accompanying LICENSE file.
+
+Author:
+    Terry Moore, MCCI Corporation   May 2020
+
+*/
+
+#ifndef _MCCI_Catena_SGPC3_Trace_h_
+# define _MCCI_Catena_SGPC3_Trace_h_
+# pragma once
+
+/// \file
+
+#include "MCCI_Catena_SGPC3.h"
+
+namespace McciCatenaSGPC3 {
+
+/// \defgroup trace Transaction tracing
+/// \{
+
+/// \brief One traced transaction, in the compact binary trace format.
+///
+/// \details
+///     Records are 28 bytes of fixed-width fields with no padding. Multi-byte
+///     fields are in host byte order (little-endian on all supported targets).
+struct SGPC3_TraceRecord_t
+    {
+    std::uint32_t tStartMs;         ///< \c millis() when the command was written.
+    std::uint32_t tStartUs;         ///< \c micros() when the command was written.
+    std::uint32_t durationUs;       ///< Time from write to completion, in microseconds, excluding arbitration.
+    std::uint16_t command;          ///< The SGPC3 command code.
+    std::uint16_t param;            ///< The parameter word, or zero.
+    std::uint8_t response[9];       ///< Raw response bytes, including CRCs.
+    std::uint8_t nResponse;         ///< Number of valid bytes in \c response.
+    std::uint8_t i2cResult;         ///< \c endTransmission() result for the write.
+    std::uint8_t error;             ///< The driver's \c Error_t for the transfer.
+    };
+
+static_assert(sizeof(SGPC3_TraceRecord_t) == 28, "SGPC3_TraceRecord_t is not compact");
+
+/*!
+
+\brief Record SGPC3 bus transactions into a fixed RAM ring.
+
+\tparam N   The number of records kept; older records are overwritten.
+
+\details
+    Attach the recorder to a sensor with cSGPC3::addObserver(). Each
+    transaction costs one 28-byte copy. Recording can be paused, for
+    example when an error is seen, so that the events leading up to a
+    field problem are preserved.
+
+    dump() writes the ring, oldest record first, as text that can be
+    captured from a serial monitor:
+
+    ```
+    SGPC3TRACE 1 <nRecords> <nDropped>
+    <56 hex digits per record>
+    ...
+    SGPC3TRACE END
+    ```
+
+    Each record line is the raw bytes of one \ref SGPC3_TraceRecord_t.
+    The host tool `tools/host/sgpc3_trace_replay.cpp` reads this format.
+
+*/
+template <unsigned N>
+class cSGPC3_TraceRecorder : public cSGPC3_cmds, public cSGPC3::cObserver
+    {
+    static_assert(N >= 1 && N <= 65535, "trace size must be in [1, 65535]");
+
+public:
+    /// \brief Format version written by dump().
+    static constexpr unsigned kFormatVersion = 1;
+
+    cSGPC3_TraceRecorder()
+        : m_nRecords(0)
+        , m_iNext(0)
+        , m_nDropped(0)
+        , m_fPaused(false)
+        {}
+
+    virtual void onTransaction(const cSGPC3::Transaction_t &t) override
+        {
+        if (this->m_fPaused)
+            return;
+
+        auto &r = this->m_records[this->m_iNext];
+
+        r.tStartMs = std::uint32_t(t.tStart);
+        r.tStartUs = t.tStartUs;
+        r.durationUs = t.tEndUs - t.tStartUs - t.arbitrationUs;
+        r.command = getCommand(t.command);
+        r.param = t.param;
+        r.nResponse = t.nResponse;
+        r.i2cResult = t.i2cResult;
+        r.error = std::uint8_t(t.result);
+        for (unsigned i = 0; i < sizeof(r.response); ++i)
+            r.response[i] = i < t.nResponse ? t.response[i] : 0;
+
+        if (++this->m_iNext == N)
+            this->m_iNext = 0;
+        if (this->m_nRecords < N)
+            ++this->m_nRecords;
+        else
+            ++this->m_nDropped;
+        }
+
+    /// \brief Stop recording; the ring is preserved.
+    void pause()
+        {
+        this->m_fPaused = true;
+        }
+
+    /// \brief Resume recording.
+    void resume()
+        {
+        this->m_fPaused = false;
+        }
+
+    /// \brief Discard all records.
+    void clear()
+        {
+        this->m_nRecords = 0;
+        this->m_iNext = 0;
+        this->m_nDropped = 0;
+        }
+
+    /// \brief Return the number of records held.
+    unsigned size() const
+        {
+        return this->m_nRecords;
+        }
+
+    /// \brief Return the number of records overwritten since the last clear().
+    std::uint32_t getDroppedCount() const
+        {
+        return this->m_nDropped;
+        }
+
+    /// \brief Return a record by age; index 0 is the oldest.
+    const SGPC3_TraceRecord_t *getRecord(unsigned i) const
+        {
+        if (i >= this->m_nRecords)
+            return nullptr;
+
+        unsigned const iFirst = this->m_nRecords < N ? 0 : this->m_iNext;
+        return &this->m_records[(iFirst + i) % N];
+        }
+
+    /// \brief Write the trace as text; see the class description for the format.
+    void dump(Print &out) const
+        {
+        static const char hex[] = "0123456789abcdef";
+
+        out.print("SGPC3TRACE ");
+        out.print(kFormatVersion);
+        out.print(' ');
+        out.print(this->m_nRecords);
+        out.print(' ');
+        out.println(this->m_nDropped);
+
+        for (unsigned i = 0; i < this->m_nRecords; ++i)
+            {
+            auto const pBytes = reinterpret_cast<const std::uint8_t *>(this->getRecord(i));
+            char line[2 * sizeof(SGPC3_TraceRecord_t) + 1];
+
+            for (unsigned j = 0; j < sizeof(SGPC3_TraceRecord_t); ++j)
+                {
+                line[2 * j] = hex[pBytes[j] >> 4];
+                line[2 * j + 1] = hex[pBytes[j] & 0xF];
+                }
+            line[sizeof(line) - 1] = '\0';
+            out.println(line);
+            }
+
+        out.println("SGPC3TRACE END");
+        }
+
+private:
+    SGPC3_TraceRecord_t m_records[N];
+    std::uint16_t m_nRecords;
+    std::uint16_t m_iNext;
+    std::uint32_t m_nDropped;
+    bool m_fPaused;
+    };
+
+// end group trace
+/// \}
+
+} // McciCatenaSGPC3
+
+#endif // _MCCI_Catena_SGPC3_Trace_h_
@@ -19,21 +19,34 @@ Author:
 
 using namespace McciCatenaSGPC3;
 
-/// \brief  Initialze the SGPC3, and fetch the feature set. 
+/// \brief  Initialze the SGPC3, fetch the feature set, and optionally restore a baseline.
+///
+/// \param mode [in]        The power mode to use.
+/// \param policy [in]      How to start continuous measurement.
+/// \param pBaseline [in]   A saved baseline to restore, or \c nullptr.
+///
 /// \details
 ///     This function fetches the version of the SGPC3. If the version suitable,
 ///     the chip is initialized for continuous operation in the specified power mode.
 ///     Remember that Sensirion says it's a bad idea to switch modes on a given device,
 ///     but also remember that we have no good way to know what mode a device is in
-///     by examining the device. On return, it's a
-cSGPC3::Error_t cSGPC3::begin(PowerMode_t mode)
+///     by examining the device.
+///
+///     With \ref StartupPolicy_t::Auto, the preheat is skipped and the baseline
+///     restored if \p pBaseline is supplied and is no older than
+///     \ref kBaselineMaxAgeMs; an older baseline is ignored, and the full preheat
+///     is used. With \ref StartupPolicy_t::Preheat or \ref StartupPolicy_t::NoPreheat,
+///     the caller has chosen, so any baseline supplied is restored regardless
+///     of its age.
+///
+///     Use isDataValid() to find out when measurements can be used.
+cSGPC3::Error_t cSGPC3::begin(PowerMode_t mode, StartupPolicy_t policy, const Baseline_t *pBaseline)
     {
     // treat this as a chip reset.
     this->handleChipReset();
 
     // get the version
     std::uint16_t featureSet;
-    std::uint8_t productVersion;
     auto result = this->sendAndGetSynchronous<Command_t::get_feature_set_version>(featureSet);
 
     this->m_featureSet = 0;
@@ -41,41 +54,110 @@ cSGPC3::Error_t cSGPC3::begin(PowerMode_t mode)
     if (! isSuccess(result))
         return result;
 
+    result = this->setFeatureSet(featureSet);
+    if (! isSuccess(result))
+        return result;
+
+    // set the mode.
+    result = this->set_power_mode_synchronous(mode);
+
+    // start the sensor; in Auto mode, a stale baseline is ignored.
+    if (policy == StartupPolicy_t::Auto)
+        {
+        if (pBaseline != nullptr && pBaseline->ageMs > kBaselineMaxAgeMs)
+            pBaseline = nullptr;
+
+        policy = pBaseline != nullptr ? StartupPolicy_t::NoPreheat
+                                      : StartupPolicy_t::Preheat;
+        }
+
+    if (policy == StartupPolicy_t::NoPreheat)
+        result = this->tvoc_init_no_preheat();
+    else
+        result = this->tvoc_init_continuous();
+
+    if (isSuccess(result) && pBaseline != nullptr)
+        result = this->set_tvoc_baseline_synchronous(pBaseline->value);
+
+    return result;
+    }
+
+/// \param featureSet [in]  The response to `get_feature_set_version`.
+///
+/// \details
+///     The feature set is cached only if the device is an SGPC3 of a version
+///     that this library supports; otherwise the cached feature set is zero.
+cSGPC3::Error_t cSGPC3::setFeatureSet(std::uint16_t featureSet)
+    {
+    this->m_featureSet = 0;
+
     if (featureSet_getProductType(featureSet) != ProductType_t::SGPC3)
         return Error_t::WrongDeviceType;
 
     // sample code checks version 4; but this library is only tested with version 6.
-    productVersion = featureSet_getProductVersion(featureSet);
+    auto const productVersion = featureSet_getProductVersion(featureSet);
     if (productVersion < 6)
         return Error_t::WrongDeviceType;
 
     this->m_featureSet = productVersion;
+    return Error_t::Success;
+    }
 
-    // set the mode.
-    result = this->set_power_mode_synchronous(mode);
+/// \details
+///     The command is launched with startCommand(), and then completed with
+///     finishCommand().
+///
+cSGPC3::Error_t cSGPC3::sendCommand(
+    cSGPC3::Command_t c,
+    const std::uint8_t *pParamBytes,
+    std::uint8_t *pResultBytes
+    )
+    {
+    auto result = this->startCommand(c, pParamBytes);
 
-    // start the sensor
-    result = this->tvoc_init_continuous();
+    if (isSuccess(result))
+        result = this->finishCommand(c, pResultBytes);
 
     return result;
     }
 
 /// \details
-///     The command is sent to the sensor, and the appropriate delay is inserted.
+///     The command and parameters are written to the sensor, but we don't wait
+///     for the command to complete. If an arbiter has been set, the write is
+///     bracketed by cBusArbiter::acquire() and cBusArbiter::release(), and the
+///     start time is taken after acquire() returns.
+///     If the write fails, the observers (if any) are notified immediately;
+///     otherwise they're notified by finishCommand().
 ///
-cSGPC3::Error_t cSGPC3::sendCommand(
+cSGPC3::Error_t cSGPC3::startCommand(
     cSGPC3::Command_t c,
-    const std::uint8_t *pParamBytes,
-    std::uint8_t *pResultBytes
+    const std::uint8_t *pParamBytes
     )
     {
     std::uint8_t i2c_result;
     const std::uint16_t cmd = getCommand(c);
+    auto const pArbiter = this->getArbiter();
+    auto &t = this->m_pending;
+
+    // any command still awaiting finishCommand() is abandoned: its response
+    // must not be read as the response to this one.
+    this->m_fPending = false;
+
+    // wait for the sensor to be available.
+    this->waitUntil(this->m_tAvail);
+
+    t.command = c;
+    t.param = pParamBytes == nullptr ? 0 : this->getbe16(pParamBytes);
+    t.nResponse = 0;
+    t.arbitrationUs = 0;
+
+    if (pArbiter != nullptr)
+        pArbiter->acquire(*this, getBusTimeUs(c));
 
-    // wait for the bus to be available.
-    auto tNow = millis();
-    while (std::int32_t(this->m_tAvail - tNow < 0))
-        tNow = millis();
+    // take the start time once we own the bus, so that other clients'
+    // traffic run by acquire() isn't counted.
+    t.tStart = millis();
+    t.tStartUs = micros();
 
     this->m_wire->beginTransmission(this->kAddress);
     this->m_wire->write(std::uint8_t(cmd >> 8));
@@ -92,9 +174,13 @@ cSGPC3::Error_t cSGPC3::sendCommand(
         }
 
     i2c_result = this->m_wire->endTransmission();
+    t.i2cResult = i2c_result;
 
-    // update available time.
-    this->m_tAvail = tNow + getDelayMs(c) + 1;
+    if (pArbiter != nullptr)
+        pArbiter->release(*this);
+
+    // update available time; allow for the partial millisecond in progress.
+    this->m_tAvail = millis() + getDelayMs(c) + 1;
 
     // check for success.
     if (i2c_result != 0)
@@ -106,32 +192,216 @@ cSGPC3::Error_t cSGPC3::sendCommand(
             Serial.print(", i2c result: ");
             Serial.println(i2c_result);
             }
-        return Error_t::WriteError;
+        t.result = Error_t::WriteError;
+        t.tEndUs = micros();
+        this->notifyObservers();
+        return t.result;
         }
 
+    this->m_fPending = true;
+    return Error_t::Success;
+    }
+
+/// \details
+///     We wait until the command has completed (giving the time to the arbiter,
+///     if any), then read the response, if the command has one. The observers
+///     (if any) are notified.
+///
+/// \retval Error_t::Failure    \p c is not the command most recently started.
+cSGPC3::Error_t cSGPC3::finishCommand(
+    cSGPC3::Command_t c,
+    std::uint8_t *pResultBytes
+    )
+    {
+    if (! this->m_fPending || this->m_pending.command != c)
+        return Error_t::Failure;
+
+    this->m_fPending = false;
+
     // wait.
-    delay(getDelayMs(c));
+    this->waitUntil(this->m_tAvail);
 
     auto const nResult = getResponseLength(c);
-    if (nResult == 0)
-        return Error_t::Success;
+    auto &t = this->m_pending;
+
+    t.result = Error_t::Success;
 
-    // now we need to read the response
-    std::uint8_t nReadFrom = this->m_wire->requestFrom(this->kAddress, nResult * 3);
-    if (nReadFrom != nResult * 3)
+    if (nResult != 0)
         {
-        if (this->isDebug())
+        // now we need to read the response
+        auto const pArbiter = this->getArbiter();
+
+        if (pArbiter != nullptr)
             {
-            Serial.print("sendCommand: nReadFrom(");
-            Serial.print(unsigned(nReadFrom));
-            Serial.print(") != nBuf(");
-            Serial.print(nResult * 3);
-            Serial.println(")");
+            auto const tAcquireUs = micros();
+
+            pArbiter->acquire(*this, kBusUsPerByte * (1 + nResult * 3));
+            t.arbitrationUs = micros() - tAcquireUs;
+            }
+
+        std::uint8_t nReadFrom = this->m_wire->requestFrom(this->kAddress, nResult * 3);
+
+        if (pArbiter != nullptr)
+            pArbiter->release(*this);
+
+        if (nReadFrom != nResult * 3)
+            {
+            if (this->isDebug())
+                {
+                Serial.print("sendCommand: nReadFrom(");
+                Serial.print(unsigned(nReadFrom));
+                Serial.print(") != nBuf(");
+                Serial.print(nResult * 3);
+                Serial.println(")");
+                }
+            t.result = Error_t::ReadError;
+            }
+        else
+            {
+            for (std::uint8_t i = 0; i < nReadFrom; ++i)
+                t.response[i] = pResultBytes[i] = std::uint8_t(this->m_wire->read());
+            t.nResponse = nReadFrom;
             }
-        return Error_t::ReadError;
         }
 
-    return Error_t::Success;
+    t.tEndUs = micros();
+    this->notifyObservers();
+    return t.result;
+    }
+
+void cSGPC3::notifyObservers() const
+    {
+    for (auto pObserver = this->m_pObservers; pObserver != nullptr; pObserver = pObserver->m_pNext)
+        pObserver->onTransaction(this->m_pending);
+    }
+
+/// \param c [in]       The measurement command.
+/// \param tCall [in]   The time (in \c millis()) when the measurement was requested.
+/// \param e [in]       The result of the measurement command.
+/// \param tvoc [in]    The TVOC value, or zero.
+/// \param raw [in]     The raw value, or zero.
+///
+/// \details
+///     The capture time is when the command was written, or \p tCall if the
+///     command was never sent (for example, because it isn't supported).
+///     The sensor updates its output once per measurement period, counting
+///     from when continuous mode was started; the age and freshness are
+///     computed from that. Reads in the first period (update 0) come before
+///     the first output, and so are never fresh. (If the power mode is changed after starting,
+///     the phase is approximate.)
+cSGPC3::Measurement_t cSGPC3::makeMeasurement(
+    Command_t c,
+    Millisecond_t tCall,
+    Error_t e,
+    std::uint16_t tvoc,
+    std::uint16_t raw
+    )
+    {
+    Measurement_t m {};
+    auto tCapture = tCall;
+
+    if (this->m_pending.command == c && std::int32_t(this->m_pending.tStart - tCall) >= 0)
+        tCapture = this->m_pending.tStart;
+
+    m.tCapture = std::uint32_t(tCapture);
+    m.command = getCommand(c);
+    m.error = e;
+    m.flags = 0;
+    m.ageMs = 0;
+    m.reserved = 0;
+
+    if (isSuccess(e))
+        {
+        m.tvoc = tvoc;
+        m.raw = raw;
+        m.flags |= Measurement_t::kFlagSuccess;
+        }
+    else
+        {
+        m.tvoc = 0;
+        m.raw = 0;
+        }
+
+    if (this->m_fStarted)
+        {
+        auto const periodMs = this->getMeasurementPeriodMs();
+        std::uint32_t const tSinceStart = tCapture - this->m_tStarted;
+        std::uint32_t const update = tSinceStart / periodMs;
+
+        m.ageMs = std::uint16_t(tSinceStart % periodMs);
+
+        if (this->isDataValid(tCapture))
+            m.flags |= Measurement_t::kFlagValid;
+
+        // m_lastUpdate starts at 0, so reads before the first output
+        // (at the end of period 0) aren't fresh.
+        if (isSuccess(e) && update != this->m_lastUpdate)
+            {
+            m.flags |= Measurement_t::kFlagFresh;
+            this->m_lastUpdate = update;
+            }
+        }
+
+    return m;
+    }
+
+/// \param tUntil [in]     The time (in \c millis()) to wait for.
+///
+/// \details
+///     If an arbiter is set, the wait is delegated to cBusArbiter::waitIdle(),
+///     which advertises the window to the other clients. Otherwise we just delay.
+void cSGPC3::waitUntil(Millisecond_t tUntil)
+    {
+    auto const pArbiter = this->getArbiter();
+
+    if (pArbiter != nullptr)
+        {
+        pArbiter->waitIdle(*this, tUntil);
+        return;
+        }
+
+    std::int32_t const tDelay = std::int32_t(tUntil - millis());
+    if (tDelay > 0)
+        delay(tDelay);
+    }
+
+/// \param observer [in]  The observer to be removed. Nothing happens if it
+///                         isn't observing this sensor.
+void cSGPC3::removeObserver(cObserver &observer)
+    {
+    if (observer.m_pSensor != this)
+        return;
+
+    for (cObserver **ppObserver = &this->m_pObservers; *ppObserver != nullptr; ppObserver = &(*ppObserver)->m_pNext)
+        {
+        if (*ppObserver == &observer)
+            {
+            *ppObserver = observer.m_pNext;
+            break;
+            }
+        }
+
+    observer.m_pNext = nullptr;
+    observer.m_pSensor = nullptr;
+    }
+
+/// \details
+///     If the sensor is already registered with a different arbiter, it is
+///     removed from that arbiter first.
+///
+/// \returns
+///     \c true if successful, \c false if the arbiter refused the registration.
+bool cSGPC3::setArbiter(cBusArbiter *pArbiter, cBusArbiter::Priority_t priority)
+    {
+    auto const pOldArbiter = this->getArbiter();
+
+    if (pOldArbiter != nullptr)
+        pOldArbiter->unregisterClient(*this);
+
+    if (pArbiter == nullptr)
+        return true;
+
+    return pArbiter->registerClient(*this, priority);
     }
 
 /// \param c [in]       Description of the command.
@@ -164,10 +434,22 @@ cSGPC3::Error_t cSGPC3::sendCommandWithParam(cSGPC3::Command_t c, std::uint16_t
 ///     to send or receive. We assume that the command returns exactly 3 bytes of
 ///     result data.
 cSGPC3::Error_t cSGPC3::sendCommandWithResponse(cSGPC3::Command_t c, std::uint16_t &response)
+    {
+    auto result = this->startCommand(c, nullptr);
+
+    if (! this->isSuccess(result))
+        return result;
+
+    return this->finishCommandWithResponse(c, response);
+    }
+
+/// \param c [in]       Description of the command, which must have been started.
+/// \param response [out]  Set to the 16-bit response (if no errors).
+cSGPC3::Error_t cSGPC3::finishCommandWithResponse(cSGPC3::Command_t c, std::uint16_t &response)
     {
     std::uint8_t responseBuf[3];
 
-    auto result = this->sendCommand(c, nullptr, responseBuf);
+    auto result = this->finishCommand(c, responseBuf);
 
     if (! this->isSuccess(result))
         return result;
@@ -216,10 +498,22 @@ cSGPC3::Error_t cSGPC3::sendCommandWithTwoResponses(cSGPC3::Command_t c, std::ui
 ///     to send or receive. We assume that the command requires exactly 9 bytes of
 ///     result data.
 cSGPC3::Error_t cSGPC3::sendCommandWithThreeResponses(cSGPC3::Command_t c, std::uint64_t &response)
+    {
+    auto result = this->startCommand(c, nullptr);
+
+    if (! this->isSuccess(result))
+        return result;
+
+    return this->finishCommandWithThreeResponses(c, response);
+    }
+
+/// \param c [in]       Description of the command, which must have been started.
+/// \param response [out]  Set to the 48-bit response (if no errors).
+cSGPC3::Error_t cSGPC3::finishCommandWithThreeResponses(cSGPC3::Command_t c, std::uint64_t &response)
     {
     std::uint8_t responseBuf[9];
 
-    auto result = this->sendCommand(c, nullptr, responseBuf);
+    auto result = this->finishCommand(c, responseBuf);
 
     if (! this->isSuccess(result))
         return result;
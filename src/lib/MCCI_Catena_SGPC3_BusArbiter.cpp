@@ -0,0 +1,228 @@
+/*
+
+Module: MCCI_Catena_SGPC3_BusArbiter.cpp
+
+Function:
+    Implementation of the shared-bus arbiter for the Catena SGPC3 library.
+
+Copyright and License:
+    See accompanying LICENSE file.
+
+Author:
+    Terry Moore, MCCI Corporation   May 2020
+
+*/
+
+/// \file
+
+#include "../MCCI_Catena_SGPC3.h"
+
+using namespace McciCatenaSGPC3;
+
+/// \param client [in]      The client to be registered.
+/// \param priority [in]    The priority of the client's traffic.
+///
+/// \returns
+///     \c true if the client was registered, \c false if it is already
+///     registered with some arbiter.
+bool cBusArbiter::registerClient(cClient &client, Priority_t priority)
+    {
+    if (client.m_pArbiter != nullptr)
+        return client.m_pArbiter == this && client.m_priority == priority;
+
+    client.m_priority = priority;
+    client.m_pArbiter = this;
+    client.m_pNext = this->m_pClients;
+    this->m_pClients = &client;
+    return true;
+    }
+
+/// \param client [in]      The client to be removed. Nothing happens if the
+///                         client isn't registered with this arbiter.
+void cBusArbiter::unregisterClient(cClient &client)
+    {
+    if (client.m_pArbiter != this)
+        return;
+
+    for (cClient **ppClient = &this->m_pClients; *ppClient != nullptr; ppClient = &(*ppClient)->m_pNext)
+        {
+        if (*ppClient == &client)
+            {
+            *ppClient = client.m_pNext;
+            break;
+            }
+        }
+
+    client.m_pNext = nullptr;
+    client.m_pArbiter = nullptr;
+    }
+
+/// \param pSkip [in]       Client to ignore (normally the caller).
+/// \param minPriority [in] Only consider clients with at least this priority.
+/// \param budgetUs [in]    Only consider transactions that fit in this many microseconds.
+///
+/// \returns
+///     The pending client with the highest priority, or \c nullptr if none.
+///     Among clients of equal priority, the shortest transaction wins.
+cBusArbiter::cClient *cBusArbiterSimple::findPending(
+    const cClient *pSkip,
+    Priority_t minPriority,
+    Microsecond_t budgetUs
+    ) const
+    {
+    cClient *pBest = nullptr;
+    Microsecond_t bestUs = 0;
+
+    for (auto pClient = this->m_pClients; pClient != nullptr; pClient = pClient->getNext())
+        {
+        if (pClient == pSkip || pClient->getPriority() < minPriority)
+            continue;
+
+        auto const pendingUs = pClient->getPendingBusTimeUs();
+        if (pendingUs == 0 || pendingUs > budgetUs)
+            continue;
+
+        if (this->isBlockedBy(pClient, pendingUs))
+            continue;
+
+        if (pBest == nullptr ||
+            pClient->getPriority() > pBest->getPriority() ||
+            (pClient->getPriority() == pBest->getPriority() && pendingUs < bestUs))
+            {
+            pBest = pClient;
+            bestUs = pendingUs;
+            }
+        }
+
+    return pBest;
+    }
+
+/// \param pCandidate [in]  The client whose transaction might be run.
+/// \param busTimeUs [in]   The estimated duration of the transaction.
+///
+/// \returns
+///     \c true if some other client with higher priority than \p pCandidate
+///     expects to need the bus before the transaction (plus \ref kGuardUs)
+///     would complete. Clients whose bus time has already arrived don't block: if they can
+///     be polled, they win on priority anyway.
+bool cBusArbiterSimple::isBlockedBy(const cClient *pCandidate, Microsecond_t busTimeUs) const
+    {
+    auto const tNow = millis();
+    auto const tEnd = tNow + (busTimeUs + kGuardUs + 999) / 1000;
+
+    for (auto pClient = this->m_pClients; pClient != nullptr; pClient = pClient->getNext())
+        {
+        Millisecond_t tDue;
+
+        if (pClient == pCandidate || pClient->getPriority() <= pCandidate->getPriority())
+            continue;
+
+        if (pClient->getNextBusTime(tDue) &&
+            std::int32_t(tDue - tNow) > 0 &&
+            std::int32_t(tEnd - tDue) > 0)
+            return true;
+        }
+
+    return false;
+    }
+
+/// \param pSkip [in]       Client to ignore (normally the caller).
+/// \param tNext [out]      Set to the earliest future bus time.
+///
+/// \returns
+///     \c true if some client other than \p pSkip reported a bus time
+///     that hasn't yet arrived, \c false otherwise.
+bool cBusArbiterSimple::getNextBusTime(const cClient *pSkip, Millisecond_t &tNext) const
+    {
+    auto const tNow = millis();
+    bool fFound = false;
+
+    for (auto pClient = this->m_pClients; pClient != nullptr; pClient = pClient->getNext())
+        {
+        Millisecond_t tDue;
+
+        if (pClient == pSkip || ! pClient->getNextBusTime(tDue) || std::int32_t(tDue - tNow) <= 0)
+            continue;
+
+        if (! fFound || std::int32_t(tDue - tNext) < 0)
+            tNext = tDue;
+        fFound = true;
+        }
+
+    return fFound;
+    }
+
+/// \details
+///     Pending transactions of clients with strictly higher priority are
+///     run first; then the caller becomes the owner of the bus. The
+///     estimate \p busTimeUs isn't used.
+void cBusArbiterSimple::acquire(cClient &client, Microsecond_t busTimeUs)
+    {
+    (void) busTimeUs;
+
+    if (client.getPriority() < Priority_t::High && this->m_pOwner == nullptr)
+        {
+        auto const minPriority = Priority_t(std::uint8_t(client.getPriority()) + 1);
+        cClient *pClient;
+
+        while ((pClient = this->findPending(&client, minPriority, ~Microsecond_t(0))) != nullptr)
+            pClient->pollBus();
+        }
+
+    this->m_pOwner = &client;
+    }
+
+void cBusArbiterSimple::release(cClient &client)
+    {
+    if (this->m_pOwner == &client)
+        this->m_pOwner = nullptr;
+    }
+
+/// \details
+///     While time remains in the window, we run the highest-priority
+///     pending transaction that fits. If a transaction is held back by
+///     a higher-priority client's bus time, we wait for that time and
+///     try again. We don't nest: if a client calls waitIdle() from within
+///     pollBus(), we simply delay.
+void cBusArbiterSimple::waitIdle(cClient &client, Millisecond_t tUntil)
+    {
+    if (this->m_pWaiter == nullptr)
+        {
+        this->m_pWaiter = &client;
+
+        for (;;)
+            {
+            std::int32_t const remainingMs = std::int32_t(tUntil - millis());
+            if (remainingMs <= 0)
+                break;
+
+            auto const budgetUs = Microsecond_t(remainingMs) * 1000;
+            if (budgetUs <= kGuardUs)
+                break;
+
+            auto const pClient = this->findPending(&client, Priority_t::Low, budgetUs - kGuardUs);
+            if (pClient == nullptr)
+                {
+                // something may have been held back for a higher-priority
+                // client; once that client's bus time arrives, look again.
+                Millisecond_t tNext;
+
+                if (! this->getNextBusTime(&client, tNext) || std::int32_t(tUntil - tNext) <= 0)
+                    break;
+
+                std::int32_t const waitMs = std::int32_t(tNext - millis());
+                if (waitMs > 0)
+                    delay(waitMs);
+                continue;
+                }
+
+            pClient->pollBus();
+            }
+
+        this->m_pWaiter = nullptr;
+        }
+
+    std::int32_t const remainingMs = std::int32_t(tUntil - millis());
+    if (remainingMs > 0)
+        delay(remainingMs);
+    }
@@ -0,0 +1,177 @@
+/*
+
+Module: MCCI_Catena_SGPC3_Energy.cpp
+
+Function:
+    Implementation of the energy-estimation model for the Catena SGPC3 library.
+
+Copyright and License:
+    See accompanying LICENSE file.
+
+Author:
+    Terry Moore, MCCI Corporation   May 2020
+
+*/
+
+/// \file
+
+#include "../MCCI_Catena_SGPC3_Energy.h"
+
+using namespace McciCatenaSGPC3;
+
+constexpr cSGPC3_EnergyModel::Parameters_t cSGPC3_EnergyModel::kDefaultParameters;
+
+/// \details
+///     An out-of-range \p initial is treated as \ref State_t::Idle.
+void cSGPC3_EnergyModel::reset(Millisecond_t when, State_t initial, PowerMode_t mode)
+    {
+    this->m_tLast = when;
+    this->m_state = initial < State_t::nStates ? initial : State_t::Idle;
+    this->m_powerMode = mode;
+
+    for (auto &pj : this->m_statePj)
+        pj = 0;
+    for (auto &ms : this->m_stateMs)
+        ms = 0;
+    for (auto &stats : this->m_commandStats)
+        {
+        stats.count = 0;
+        stats.picojoules = 0;
+        }
+    }
+
+/// \details
+///     Background energy is charged up to the time of the reset. The chip
+///     then returns to idle, in low-power mode (its default).
+void cSGPC3_EnergyModel::onChipReset(Millisecond_t when)
+    {
+    this->accumulateTo(when);
+    this->m_state = State_t::Idle;
+    this->m_powerMode = PowerMode_t::Low;
+    }
+
+/// \details
+///     Background energy is charged up to the start of the command, and
+///     the command is charged for its execution time and bus time. Then
+///     the background state is updated if the command changed it.
+void cSGPC3_EnergyModel::onTransaction(const cSGPC3::Transaction_t &t)
+    {
+    this->accumulateTo(t.tStart);
+
+    auto &stats = this->m_commandStats[getCommandIndex(t.command)];
+    std::uint64_t pj;
+
+    pj = this->picojoulesFromUs(this->m_params.uaBus, cSGPC3::getBusTimeUs(t.command));
+
+    // a write error means the command never executed.
+    if (t.result != cSGPC3::Error_t::WriteError)
+        {
+        auto const ua = t.command == Command_t::measure_test
+                            ? this->m_params.uaTest
+                            : this->m_params.uaCommand;
+
+        pj += this->picojoulesFromMs(ua, getDelayMs(t.command));
+        }
+
+    ++stats.count;
+    stats.picojoules += pj;
+
+    if (! cSGPC3::isSuccess(t.result))
+        return;
+
+    if (t.command == Command_t::set_power_mode)
+        {
+        this->m_powerMode = t.param == 0 ? PowerMode_t::UltraLow : PowerMode_t::Low;
+        if (this->m_state != State_t::Idle)
+            this->m_state = this->m_powerMode == PowerMode_t::UltraLow ? State_t::UltraLow : State_t::Low;
+        }
+    else if (t.command == Command_t::tvoc_init_continuous ||
+             t.command == Command_t::tvoc_init_no_preheat)
+        {
+        this->m_state = this->m_powerMode == PowerMode_t::UltraLow ? State_t::UltraLow : State_t::Low;
+        }
+    }
+
+/// \details
+///     Times earlier than the last accounted time are ignored, so it's
+///     safe to call this at any time.
+void cSGPC3_EnergyModel::accumulateTo(Millisecond_t tNow)
+    {
+    std::int32_t const dt = std::int32_t(tNow - this->m_tLast);
+
+    if (dt <= 0)
+        return;
+
+    auto const iState = unsigned(this->m_state);
+
+    this->m_statePj[iState] += this->picojoulesFromMs(this->getStateCurrent(this->m_state), dt);
+    this->m_stateMs[iState] += dt;
+    this->m_tLast = tNow;
+    }
+
+std::uint64_t cSGPC3_EnergyModel::getTotalPicojoules() const
+    {
+    std::uint64_t result = 0;
+
+    for (auto pj : this->m_statePj)
+        result += pj;
+    for (auto &stats : this->m_commandStats)
+        result += stats.picojoules;
+
+    return result;
+    }
+
+std::uint16_t cSGPC3_EnergyModel::getStateCurrent(State_t s) const
+    {
+    switch (s)
+        {
+    case State_t::UltraLow:     return this->m_params.uaUltraLow;
+    case State_t::Low:          return this->m_params.uaLow;
+    default:                    return this->m_params.uaIdle;
+        }
+    }
+
+/// \details
+///     Indices follow the numerical order of the command codes, except that
+///     `tvoc_init_no_preheat` (added later) is last.
+unsigned cSGPC3_EnergyModel::getCommandIndex(Command_t c)
+    {
+    switch (c)
+        {
+    case Command_t::measure_tvoc:                   return 0;
+    case Command_t::get_tvoc_baseline:              return 1;
+    case Command_t::set_tvoc_baseline:              return 2;
+    case Command_t::get_feature_set_version:        return 3;
+    case Command_t::measure_test:                   return 4;
+    case Command_t::measure_tvoc_and_raw:           return 5;
+    case Command_t::measure_raw:                    return 6;
+    case Command_t::set_absolute_humidity:          return 7;
+    case Command_t::tvoc_init_no_preheat:           return 12;
+    case Command_t::set_power_mode:                 return 8;
+    case Command_t::tvoc_init_continuous:           return 9;
+    case Command_t::get_tvoc_inceptive_baseline:    return 10;
+    default:                                        return 11;
+        }
+    }
+
+const char *cSGPC3_EnergyModel::getCommandName(unsigned iCommand)
+    {
+    static const char * const names[kNumCommands] =
+        {
+        "measure_tvoc",
+        "get_tvoc_baseline",
+        "set_tvoc_baseline",
+        "get_feature_set_version",
+        "measure_test",
+        "measure_tvoc_and_raw",
+        "measure_raw",
+        "set_absolute_humidity",
+        "set_power_mode",
+        "tvoc_init_continuous",
+        "get_tvoc_inceptive_baseline",
+        "get_serial_id",
+        "tvoc_init_no_preheat",
+        };
+
+    return iCommand < kNumCommands ? names[iCommand] : "?";
+    }
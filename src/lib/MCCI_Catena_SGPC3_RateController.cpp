@@ -0,0 +1,138 @@
+/*
+
+Module: MCCI_Catena_SGPC3_RateController.cpp
+
+Function:
+    Implementation of the adaptive host read-rate controller.
+
+Copyright and License:
+    See accompanying LICENSE file.
+
+Author:
+    Terry Moore, MCCI Corporation   May 2020
+
+*/
+
+/// \file
+
+#include "../MCCI_Catena_SGPC3_RateController.h"
+
+using namespace McciCatenaSGPC3;
+
+constexpr cSGPC3_RateController::Config_t cSGPC3_RateController::kDefaultConfig;
+
+void cSGPC3_RateController::reset()
+    {
+    this->m_nWindow = 0;
+    this->m_iWindow = 0;
+    this->m_divider = 1;
+    this->m_last = 0;
+    this->m_tLast = 0;
+    this->m_tNext = this->m_pSensor->getDataValidTime();
+    this->m_nReads = 0;
+    this->m_nSkipped = 0;
+    }
+
+cSGPC3_RateController::Millisecond_t cSGPC3_RateController::getNextReadTime() const
+    {
+    auto const tValid = this->m_pSensor->getDataValidTime();
+
+    if (std::int32_t(this->m_tNext - tValid) < 0)
+        return tValid;
+    else
+        return this->m_tNext;
+    }
+
+bool cSGPC3_RateController::poll(std::uint16_t &tvoc, Millisecond_t tNow)
+    {
+    if (! this->isReadDue(tNow))
+        return false;
+
+    std::uint16_t value;
+    auto const result = this->m_pSensor->measure_tvoc_synchronous(value);
+
+    if (! cSGPC3::isSuccess(result))
+        {
+        // try again at the next sensor update.
+        this->m_tNext = tNow + this->m_pSensor->getMeasurementPeriodMs();
+        return false;
+        }
+
+    this->update(value, tNow);
+    tvoc = value;
+    return true;
+    }
+
+/// \details
+///     The rate of change is measured against the previous sample, scaled
+///     to one sensor period. Activity resets the interval to one period;
+///     a flat signal (low rate and low variance over a full window) doubles
+///     it; anything in between leaves it alone.
+void cSGPC3_RateController::update(std::uint16_t tvoc, Millisecond_t tRead)
+    {
+    auto const periodMs = this->m_pSensor->getMeasurementPeriodMs();
+
+    if (this->m_nReads != 0)
+        {
+        // number of sensor periods since the last read, at least one.
+        std::uint32_t periods = (tRead - this->m_tLast + periodMs / 2) / periodMs;
+        if (periods == 0)
+            periods = 1;
+
+        this->m_nSkipped += periods - 1;
+
+        std::uint32_t const delta = tvoc > this->m_last ? tvoc - this->m_last : this->m_last - tvoc;
+        std::uint32_t const rate = (delta + periods - 1) / periods;
+
+        if (rate > this->m_config.activityRate || delta > this->m_config.activityStep)
+            {
+            this->m_divider = 1;
+            // the window describes the old level; start again.
+            this->m_nWindow = 0;
+            }
+        else if (rate <= this->m_config.flatRate &&
+                 this->m_nWindow == kWindow &&
+                 this->getVariance() <= this->m_config.flatVariance &&
+                 this->m_divider < this->m_config.maxDivider)
+            {
+            this->m_divider = this->m_divider > this->m_config.maxDivider / 2
+                                ? this->m_config.maxDivider
+                                : this->m_divider * 2;
+            }
+        }
+
+    this->m_window[this->m_iWindow] = tvoc;
+    this->m_iWindow = (this->m_iWindow + 1) % kWindow;
+    if (this->m_nWindow < kWindow)
+        ++this->m_nWindow;
+
+    ++this->m_nReads;
+    this->m_last = tvoc;
+    this->m_tLast = tRead;
+    this->m_tNext = tRead + this->m_divider * periodMs;
+    }
+
+std::uint32_t cSGPC3_RateController::getVariance() const
+    {
+    if (this->m_nWindow < 2)
+        return 0;
+
+    std::uint32_t sum = 0;
+    for (unsigned i = 0; i < this->m_nWindow; ++i)
+        sum += this->m_window[i];
+
+    std::uint32_t const mean = (sum + this->m_nWindow / 2) / this->m_nWindow;
+    std::uint32_t sumSq = 0;
+
+    for (unsigned i = 0; i < this->m_nWindow; ++i)
+        {
+        std::int32_t const d = std::int32_t(this->m_window[i]) - std::int32_t(mean);
+        std::uint32_t const ad = std::uint32_t(d < 0 ? -d : d);
+        std::uint32_t const d2 = ad * ad;
+
+        // saturate rather than overflow; anything this large is "active".
+        sumSq = (sumSq > ~d2) ? ~std::uint32_t(0) : sumSq + d2;
+        }
+
+    return sumSq / this->m_nWindow;
+    }
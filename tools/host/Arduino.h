@@ -0,0 +1,87 @@
+/*
+
+Module: Arduino.h
+
+Function:
+    Minimal host-side stand-in for the Arduino core, for the SGPC3 host tools.
+
+Copyright and License:
+    See accompanying LICENSE file.
+
+Author:
+    Terry Moore, MCCI Corporation   May 2020
+
+*/
+
+#ifndef _Arduino_h_
+# define _Arduino_h_
+# pragma once
+
+/// \file
+
+#include <cstddef>
+#include <cstdint>
+
+/// \brief Radix selector for Serial.print().
+#define HEX 16
+
+/// \brief Return the current virtual time in milliseconds.
+unsigned long millis();
+
+/// \brief Return the current virtual time in microseconds.
+unsigned long micros();
+
+/// \brief Advance the current virtual time.
+void delay(unsigned long ms);
+
+/// \brief Host-side virtual clock.
+///
+/// \details
+///     There is a single timeline, in microseconds, shared by all the
+///     simulated buses and devices. The driver advances it through
+///     \c delay() and bus transfers; a host tool moves it forward with
+///     setNow() or advance() when its executor is idle until the next
+///     event. The fleet simulator never moves it backwards, so a blocking
+///     call for one sensor delays every other sensor.
+namespace HostClock {
+    /// \brief Set the current time, in microseconds.
+    void setNow(std::uint64_t tUs);
+    /// \brief Get the current time, in microseconds.
+    std::uint64_t getNow();
+    /// \brief Advance the current time by \p dUs microseconds.
+    void advance(std::uint64_t dUs);
+}
+
+/// \brief Stand-in for the Arduino \c Print class.
+class Print
+    {
+public:
+    virtual std::size_t write(std::uint8_t b) = 0;
+
+    std::size_t print(const char *s);
+    std::size_t print(char c) { return this->write(std::uint8_t(c)); }
+    std::size_t print(unsigned long v, int base = 10);
+    std::size_t print(long v, int base = 10);
+    std::size_t print(unsigned v, int base = 10) { return this->print((unsigned long) v, base); }
+    std::size_t print(int v, int base = 10) { return this->print((long) v, base); }
+
+    template <typename T>
+    std::size_t println(T v) { return this->print(v) + this->println(); }
+    template <typename T>
+    std::size_t println(T v, int base) { return this->print(v, base) + this->println(); }
+    std::size_t println() { return this->print("\n"); }
+
+protected:
+    ~Print() = default;
+    };
+
+/// \brief Stand-in for the Arduino \c Serial object; output goes to \c stdout.
+class HostSerial : public Print
+    {
+public:
+    virtual std::size_t write(std::uint8_t b) override;
+    };
+
+extern HostSerial Serial;
+
+#endif // _Arduino_h_
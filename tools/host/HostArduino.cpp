@@ -0,0 +1,150 @@
+/*
+
+Module: HostArduino.cpp
+
+Function:
+    Host-side implementation of the Arduino and TwoWire stand-ins.
+
+Copyright and License:
+    See accompanying LICENSE file.
+
+Author:
+    Terry Moore, MCCI Corporation   May 2020
+
+*/
+
+/// \file
+
+#include "Arduino.h"
+#include "Wire.h"
+
+#include <cstdio>
+
+HostSerial Serial;
+
+std::size_t Print::print(const char *s)
+    {
+    std::size_t n = 0;
+
+    while (*s != '\0')
+        n += this->write(std::uint8_t(*s++));
+
+    return n;
+    }
+
+std::size_t Print::print(unsigned long v, int base)
+    {
+    char buf[8 * sizeof(v) + 1];
+    char *p = buf + sizeof(buf) - 1;
+
+    if (base < 2 || base > 16)
+        base = 10;
+
+    *p = '\0';
+    do  {
+        *--p = "0123456789ABCDEF"[v % base];
+        v /= base;
+        } while (v != 0);
+
+    return this->print(p);
+    }
+
+std::size_t Print::print(long v, int base)
+    {
+    if (v < 0 && base == 10)
+        return this->print('-') + this->print((unsigned long) -v, base);
+
+    return this->print((unsigned long) v, base);
+    }
+
+std::size_t HostSerial::write(std::uint8_t b)
+    {
+    return std::fputc(b, stdout) == EOF ? 0 : 1;
+    }
+
+static std::uint64_t s_tNowUs;
+
+void HostClock::setNow(std::uint64_t tUs)
+    {
+    s_tNowUs = tUs;
+    }
+
+std::uint64_t HostClock::getNow()
+    {
+    return s_tNowUs;
+    }
+
+void HostClock::advance(std::uint64_t dUs)
+    {
+    s_tNowUs += dUs;
+    }
+
+unsigned long millis()
+    {
+    return (unsigned long)(std::uint32_t(s_tNowUs / 1000));
+    }
+
+unsigned long micros()
+    {
+    return (unsigned long)(std::uint32_t(s_tNowUs));
+    }
+
+void delay(unsigned long ms)
+    {
+    s_tNowUs += std::uint64_t(ms) * 1000;
+    }
+
+void TwoWire::charge(std::size_t nBytes)
+    {
+    auto const dUs = std::uint64_t(nBytes) * this->m_usPerByte;
+
+    this->m_busyUs += dUs;
+    HostClock::advance(dUs);
+    }
+
+void TwoWire::beginTransmission(std::uint8_t address)
+    {
+    this->m_address = address;
+    this->m_nTx = 0;
+    }
+
+std::size_t TwoWire::write(std::uint8_t b)
+    {
+    if (this->m_nTx >= sizeof(this->m_tx))
+        return 0;
+
+    this->m_tx[this->m_nTx++] = b;
+    return 1;
+    }
+
+std::uint8_t TwoWire::endTransmission(bool fStop)
+    {
+    (void) fStop;
+
+    if (this->m_pDevice == nullptr)
+        {
+        this->charge(1);
+        return 2;
+        }
+
+    auto const result = this->m_pDevice->onWrite(this->m_address, this->m_tx, this->m_nTx);
+
+    // an address NACK ends the transfer after one byte.
+    this->charge(result == 2 ? 1 : 1 + this->m_nTx);
+    return result;
+    }
+
+std::uint8_t TwoWire::requestFrom(std::uint8_t address, std::uint8_t n)
+    {
+    this->m_iRx = 0;
+    this->m_nRx = 0;
+
+    if (n > sizeof(this->m_rx))
+        n = sizeof(this->m_rx);
+
+    if (this->m_pDevice != nullptr)
+        this->m_nRx = this->m_pDevice->onRead(address, this->m_rx, n);
+
+    this->charge(1 + this->m_nRx);
+    return std::uint8_t(this->m_nRx);
+    }
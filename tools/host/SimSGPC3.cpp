@@ -0,0 +1,221 @@
+/*
+
+Module: SimSGPC3.cpp
+
+Function:
+    Simulated Sensirion SGPC3 device, for the SGPC3 host tools.
+
+Copyright and License:
+    See accompanying LICENSE file.
+
+Author:
+    Terry Moore, MCCI Corporation   May 2020
+
+*/
+
+/// \file
+
+#include "SimSGPC3.h"
+#include <cmath>
+
+constexpr std::uint8_t SimSGPC3::kAddress;
+
+SimSGPC3::SimSGPC3(const Config_t &config, std::uint32_t seed)
+    : m_config(config)
+    , m_rng(seed)
+    {
+    this->powerOn();
+    }
+
+void SimSGPC3::powerOn()
+    {
+    std::uniform_real_distribution<double> background(20.0, 120.0);
+
+    this->m_fRunning = false;
+    this->m_fUltraLow = false;
+    this->m_baseline = 0;
+    this->m_tInitUs = 0;
+    this->m_tBusyUntilUs = HostClock::getNow();
+    this->m_tSignalUs = HostClock::getNow();
+    this->m_background = background(this->m_rng);
+    this->m_event = 0;
+    this->m_tvoc = 0;
+    this->m_raw = 0;
+    this->m_nResponse = 0;
+    }
+
+std::uint8_t SimSGPC3::crc(const std::uint8_t *pBuf, std::size_t nBuf)
+    {
+    std::uint8_t crc8 = 0xFF;
+
+    for (std::size_t i = 0; i < nBuf; ++i)
+        {
+        crc8 ^= pBuf[i];
+        for (int bit = 0; bit < 8; ++bit)
+            crc8 = (crc8 & 0x80) ? std::uint8_t((crc8 << 1) ^ 0x31) : std::uint8_t(crc8 << 1);
+        }
+
+    return crc8;
+    }
+
+bool SimSGPC3::chance(std::uint32_t ppm)
+    {
+    if (ppm == 0)
+        return false;
+
+    return std::uniform_int_distribution<std::uint32_t>(0, 999999)(this->m_rng) < ppm;
+    }
+
+void SimSGPC3::putWord(std::uint16_t w)
+    {
+    auto const p = this->m_response + this->m_nResponse;
+
+    p[0] = std::uint8_t(w >> 8);
+    p[1] = std::uint8_t(w);
+    p[2] = crc(p, 2);
+    if (this->chance(this->m_config.crcErrorPpm))
+        p[2] ^= 0x5A;
+
+    this->m_nResponse += 3;
+    }
+
+/// \details
+///     The device only updates its outputs once per measurement period
+///     (2 s or 30 s), so we step the model in whole periods.
+void SimSGPC3::updateSignal(std::uint64_t tNowUs)
+    {
+    if (! this->m_fRunning)
+        return;
+
+    std::uint64_t const periodUs = this->m_fUltraLow ? 30000000u : 2000000u;
+    std::normal_distribution<double> noise(0.0, 1.0);
+    std::exponential_distribution<double> eventSize(1.0 / 400.0);
+    double const dt = double(periodUs) / 1e6;
+    // about one event per half hour.
+    std::uint32_t const eventPpm = std::uint32_t(1e6 * dt / 1800.0);
+
+    while (this->m_tSignalUs + periodUs <= tNowUs)
+        {
+        this->m_tSignalUs += periodUs;
+
+        // mean-reverting background around 60 ppb.
+        this->m_background += 0.01 * dt * (60.0 - this->m_background) + 0.8 * std::sqrt(dt) * noise(this->m_rng);
+        if (this->m_background < 0)
+            this->m_background = 0;
+
+        // events decay with a five-minute time constant.
+        this->m_event *= std::exp(-dt / 300.0);
+        if (this->chance(eventPpm))
+            this->m_event += eventSize(this->m_rng);
+
+        double tvoc = this->m_background + this->m_event + 2.0 * noise(this->m_rng);
+        if (tvoc < 0)
+            tvoc = 0;
+        if (tvoc > 60000)
+            tvoc = 60000;
+
+        if (this->m_tSignalUs - this->m_tInitUs < std::uint64_t(this->m_config.preheatMs) * 1000)
+            this->m_tvoc = 0;
+        else
+            this->m_tvoc = std::uint16_t(tvoc);
+
+        this->m_raw = std::uint16_t(40000.0 - 512.0 * std::log(1.0 + tvoc));
+        }
+    }
+
+std::uint8_t SimSGPC3::onWrite(std::uint8_t address, const std::uint8_t *pBuf, std::size_t nBuf)
+    {
+    auto const tNowUs = HostClock::getNow();
+
+    if (address != kAddress)
+        return 2;
+    if (tNowUs < this->m_tBusyUntilUs || this->chance(this->m_config.nackPpm))
+        return 2;
+    if (nBuf < 2)
+        return 3;
+
+    std::uint16_t const cmd = std::uint16_t((pBuf[0] << 8) | pBuf[1]);
+    std::uint16_t param = 0;
+    std::uint32_t delayMs = 10;
+
+    if (nBuf >= 5)
+        {
+        if (crc(pBuf + 2, 2) != pBuf[4])
+            return 3;
+        param = std::uint16_t((pBuf[2] << 8) | pBuf[3]);
+        }
+
+    this->updateSignal(tNowUs);
+    this->m_nResponse = 0;
+
+    switch (cmd)
+        {
+    case 0x2008:    // measure_tvoc
+        delayMs = 50;
+        this->putWord(this->m_tvoc);
+        break;
+    case 0x2015:    // get_tvoc_baseline
+    case 0x20b3:    // get_tvoc_inceptive_baseline
+        this->putWord(this->m_baseline);
+        break;
+    case 0x201e:    // set_tvoc_baseline
+        this->m_baseline = param;
+        break;
+    case 0x202f:    // get_feature_set_version: SGPC3, version 6
+        this->putWord(0x1006);
+        break;
+    case 0x2032:    // measure_test
+        delayMs = 220;
+        this->putWord(0xD400);
+        break;
+    case 0x2046:    // measure_tvoc_and_raw
+        delayMs = 50;
+        this->putWord(this->m_tvoc);
+        this->putWord(this->m_raw);
+        break;
+    case 0x204d:    // measure_raw
+        delayMs = 50;
+        this->putWord(this->m_raw);
+        break;
+    case 0x2061:    // set_absolute_humidity
+        break;
+    case 0x209f:    // set_power_mode
+        this->m_fUltraLow = (param == 0);
+        break;
+    case 0x20ae:    // tvoc_init_continuous
+    case 0x2089:    // tvoc_init_no_preheat
+        this->m_fRunning = true;
+        this->m_tInitUs = tNowUs;
+        this->m_tSignalUs = tNowUs;
+        if (cmd == 0x2089)
+            this->m_tInitUs -= std::uint64_t(this->m_config.preheatMs) * 1000;
+        break;
+    case 0x3682:    // get_serial_id
+        delayMs = 1;
+        this->putWord(std::uint16_t(this->m_config.serialId >> 32));
+        this->putWord(std::uint16_t(this->m_config.serialId >> 16));
+        this->putWord(std::uint16_t(this->m_config.serialId));
+        break;
+    default:
+        return 3;
+        }
+
+    this->m_tBusyUntilUs = tNowUs + std::uint64_t(delayMs) * 1000;
+    return 0;
+    }
+
+std::size_t SimSGPC3::onRead(std::uint8_t address, std::uint8_t *pBuf, std::size_t nBuf)
+    {
+    if (address != kAddress)
+        return 0;
+    if (HostClock::getNow() < this->m_tBusyUntilUs || this->chance(this->m_config.nackPpm))
+        return 0;
+    if (nBuf > this->m_nResponse)
+        nBuf = this->m_nResponse;
+
+    for (std::size_t i = 0; i < nBuf; ++i)
+        pBuf[i] = this->m_response[i];
+
+    this->m_nResponse = 0;
+    return nBuf;
+    }
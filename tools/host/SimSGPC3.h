@@ -0,0 +1,93 @@
+/*
+
+Module: SimSGPC3.h
+
+Function:
+    Simulated Sensirion SGPC3 device, for the SGPC3 host tools.
+
+Copyright and License:
+    See accompanying LICENSE file.
+
+Author:
+    Terry Moore, MCCI Corporation   May 2020
+
+*/
+
+#ifndef _SimSGPC3_h_
+# define _SimSGPC3_h_
+# pragma once
+
+/// \file
+
+#include "Wire.h"
+#include <random>
+
+/// \brief Simulated SGPC3 device.
+///
+/// \details
+///     The device answers the SGPC3 command set at address 0x58, enforces
+///     the command execution delays (reading early is NACKed, as on the
+///     real device), and produces a TVOC trace made of a mean-reverting
+///     background plus occasional decaying events. The raw signal is
+///     derived from the TVOC value, falling logarithmically as TVOC rises.
+///
+///     Faults can be injected: CRC errors (a response CRC byte is
+///     corrupted) and NACKs (a write or read is refused), each with a
+///     given probability in parts per million.
+class SimSGPC3 : public HostI2cDevice
+    {
+public:
+    /// \brief Fault-injection and signal settings.
+    struct Config_t
+        {
+        std::uint32_t crcErrorPpm;      ///< Probability of a corrupted response CRC.
+        std::uint32_t nackPpm;          ///< Probability of a NACK on any transfer.
+        std::uint32_t preheatMs;        ///< Time after init during which TVOC reads as zero.
+        std::uint64_t serialId;         ///< The 48-bit serial ID.
+        };
+
+    SimSGPC3(const Config_t &config, std::uint32_t seed);
+
+    virtual std::uint8_t onWrite(std::uint8_t address, const std::uint8_t *pBuf, std::size_t nBuf) override;
+    virtual std::size_t onRead(std::uint8_t address, std::uint8_t *pBuf, std::size_t nBuf) override;
+
+    /// \brief Simulate a power-on reset.
+    void powerOn();
+
+    /// \brief The Sensirion CRC-8 (polynomial 0x31, initial value 0xFF).
+    static std::uint8_t crc(const std::uint8_t *pBuf, std::size_t nBuf);
+
+    /// \brief Fixed I2C address of the device.
+    static constexpr std::uint8_t kAddress = 0x58;
+
+private:
+    /// \brief Advance the signal model to the current time.
+    void updateSignal(std::uint64_t tNowUs);
+    /// \brief Queue a response word.
+    void putWord(std::uint16_t w);
+    /// \brief Return true with probability \p ppm parts per million.
+    bool chance(std::uint32_t ppm);
+
+    Config_t m_config;
+    std::mt19937 m_rng;
+
+    // device state
+    bool m_fRunning;
+    bool m_fUltraLow;
+    std::uint16_t m_baseline;
+    std::uint64_t m_tInitUs;
+    std::uint64_t m_tBusyUntilUs;
+
+    // signal model
+    std::uint64_t m_tSignalUs;
+    double m_background;
+    double m_event;
+    std::uint16_t m_tvoc;
+    std::uint16_t m_raw;
+
+    // pending response
+    std::uint8_t m_response[9];
+    std::size_t m_nResponse;
+    };
+
+#endif // _SimSGPC3_h_
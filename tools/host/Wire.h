@@ -0,0 +1,95 @@
+/*
+
+Module: Wire.h
+
+Function:
+    Host-side stand-in for the Arduino TwoWire class, backed by simulated devices.
+
+Copyright and License:
+    See accompanying LICENSE file.
+
+Author:
+    Terry Moore, MCCI Corporation   May 2020
+
+*/
+
+#ifndef _Wire_h_
+# define _Wire_h_
+# pragma once
+
+/// \file
+
+#include "Arduino.h"
+
+/// \brief Interface to a simulated I2C device.
+class HostI2cDevice
+    {
+public:
+    /// \brief Handle a write transfer.
+    ///
+    /// \returns the \c endTransmission() result: 0 for success, 2 for an
+    ///     address NACK, 3 for a data NACK.
+    virtual std::uint8_t onWrite(std::uint8_t address, const std::uint8_t *pBuf, std::size_t nBuf) = 0;
+
+    /// \brief Handle a read transfer.
+    ///
+    /// \returns the number of bytes supplied; 0 means the device NACKed its address.
+    virtual std::size_t onRead(std::uint8_t address, std::uint8_t *pBuf, std::size_t nBuf) = 0;
+
+protected:
+    ~HostI2cDevice() = default;
+    };
+
+/// \brief Simulated I2C bus, with the subset of the \c TwoWire API used by the library.
+///
+/// \details
+///     Each byte transferred (including the address byte) advances the
+///     virtual clock by the time taken at the configured bus clock, and
+///     is added to the busy time of the bus.
+class TwoWire
+    {
+public:
+    TwoWire()
+        : m_pDevice(nullptr)
+        , m_usPerByte(90)
+        , m_busyUs(0)
+        , m_nTx(0)
+        , m_nRx(0)
+        , m_iRx(0)
+        {}
+
+    /// \brief Attach the device that answers on this bus.
+    void attach(HostI2cDevice *pDevice) { this->m_pDevice = pDevice; }
+
+    /// \brief Set the bus speed in Hz.
+    void setClock(std::uint32_t hz) { this->m_usPerByte = (9 * 1000000u + hz - 1) / hz; }
+
+    /// \brief Return the accumulated bus-busy time, in microseconds.
+    std::uint64_t getBusyUs() const { return this->m_busyUs; }
+
+    void begin() {}
+    void beginTransmission(std::uint8_t address);
+    void beginTransmission(int address) { this->beginTransmission(std::uint8_t(address)); }
+    std::size_t write(std::uint8_t b);
+    std::uint8_t endTransmission(bool fStop = true);
+    std::uint8_t requestFrom(std::uint8_t address, std::uint8_t n);
+    std::uint8_t requestFrom(int address, int n) { return this->requestFrom(std::uint8_t(address), std::uint8_t(n)); }
+    int available() const { return int(this->m_nRx - this->m_iRx); }
+    int read() { return this->m_iRx < this->m_nRx ? this->m_rx[this->m_iRx++] : -1; }
+
+private:
+    /// \brief Charge bus time for \p nBytes bytes.
+    void charge(std::size_t nBytes);
+
+    HostI2cDevice *m_pDevice;
+    std::uint32_t m_usPerByte;
+    std::uint64_t m_busyUs;
+    std::uint8_t m_address;
+    std::uint8_t m_tx[32];
+    std::uint8_t m_rx[32];
+    std::size_t m_nTx;
+    std::size_t m_nRx;
+    std::size_t m_iRx;
+    };
+
+#endif // _Wire_h_
@@ -0,0 +1,527 @@
+/*
+
+Module: sgpc3_check.cpp
+
+Function:
+    Host-only checks of the bus arbiter and split-phase commands, and of
+    the header-only parts of the library.
+
+Copyright and License:
+    See accompanying LICENSE file.
+
+Author:
+    Terry Moore, MCCI Corporation   May 2020
+
+Build:
+    From the top of the repository:
+
+        g++ -std=c++11 -O2 -Itools/host -Isrc -o sgpc3_check \
+            tools/host/sgpc3_check.cpp tools/host/SimSGPC3.cpp \
+            tools/host/HostArduino.cpp src/lib/MCCI_Catena_SGPC3*.cpp
+
+Usage:
+    sgpc3_check
+
+    Runs each check, printing one line per check; the exit status is
+    non-zero if any check failed.
+
+*/
+
+/// \file
+
+#include <MCCI_Catena_SGPC3.h>
+#include <MCCI_Catena_SGPC3_Filter.h>
+#include <MCCI_Catena_SGPC3_Registry.h>
+#include "SimSGPC3.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace McciCatenaSGPC3;
+
+namespace {
+
+unsigned gnFailed;
+
+void check(bool fPass, const char *pName)
+    {
+    std::printf("%s: %s\n", fPass ? "pass" : "FAIL", pName);
+    if (! fPass)
+        ++gnFailed;
+    }
+
+/// \brief Reference median: the lower median, as cSortedWindow defines it.
+Sample_t refMedian(std::vector<Sample_t> v)
+    {
+    std::sort(v.begin(), v.end());
+    return v[(v.size() - 1) / 2];
+    }
+
+/// \brief Reference median absolute deviation.
+Sample_t refMad(const std::vector<Sample_t> &v)
+    {
+    auto const m = refMedian(v);
+    std::vector<Sample_t> d;
+
+    for (auto x : v)
+        d.push_back(Sample_t(x > m ? x - m : m - x));
+
+    return refMedian(d);
+    }
+
+/// \brief Compare cSortedWindow with the reference, over random streams.
+void checkSortedWindow()
+    {
+    std::mt19937 rng(1);
+    cSortedWindow<7> window;
+    std::vector<Sample_t> recent;
+    bool fMedian = true;
+    bool fMad = true;
+
+    for (unsigned i = 0; i < 20000; ++i)
+        {
+        // mix narrow and full-range values, with many duplicates.
+        Sample_t const v = (i / 1000) % 2 ? Sample_t(rng()) : Sample_t(rng() % 8);
+
+        window.push(v);
+        recent.push_back(v);
+        if (recent.size() > 7)
+            recent.erase(recent.begin());
+
+        fMedian = fMedian && window.median() == refMedian(recent);
+        fMad = fMad && window.mad() == refMad(recent);
+        }
+
+    check(fMedian, "cSortedWindow::median() matches sort");
+    check(fMad, "cSortedWindow::mad() matches sort");
+    }
+
+/// \brief Check Hampel rejection against a floating-point reference.
+///
+/// \details
+///     The signal is raw-like (around 40000 ticks) and very noisy, so the
+///     MAD is large; with the widest threshold, the integer comparison
+///     needs more than 32 bits.
+void checkHampel()
+    {
+    std::mt19937 rng(2);
+    cHampelFilter<7> filter(255, 1);
+    cSortedWindow<7> window;
+    bool fMatch = true;
+    unsigned nExpected = 0;
+
+    for (unsigned i = 0; i < 20000; ++i)
+        {
+        Sample_t v = Sample_t(40000 + int(rng() % 30001) - 15000);
+
+        // occasional spikes.
+        if (i % 97 == 0)
+            v = (i / 97) % 2 ? 0 : 65535;
+
+        Sample_t out;
+        filter.put(v, out);
+        window.push(v);
+
+        auto expect = v;
+        if (window.size() >= 3)
+            {
+            auto const m = window.median();
+            auto const dev = v > m ? v - m : m - v;
+
+            if (dev > 1 && dev * 10000.0 > 255.0 * 1483.0 * window.mad())
+                {
+                expect = m;
+                ++nExpected;
+                }
+            }
+
+        fMatch = fMatch && out == expect;
+        }
+
+    check(fMatch && filter.getRejectedCount() == nExpected, "cHampelFilter rejects exactly the outliers (wide threshold, large MAD)");
+
+    // three-sigma filter on a flat signal: spikes go, small noise stays.
+    cHampelFilter<5> tight;
+    unsigned nChanged = 0;
+
+    for (unsigned i = 0; i < 1000; ++i)
+        {
+        Sample_t const v = i % 50 == 25 ? 500 : Sample_t(100 + i % 2);
+        Sample_t out;
+
+        tight.put(v, out);
+        if (out != v)
+            ++nChanged;
+        }
+
+    check(nChanged == 20 && tight.getRejectedCount() == 20, "cHampelFilter removes isolated spikes and keeps noise");
+    }
+
+/// \brief Check the decimator's output cadence and rounding.
+void checkDecimator()
+    {
+    cDecimator<4> decimator;
+    bool fCadence = true;
+    bool fValue = true;
+
+    for (unsigned i = 0; i < 400; ++i)
+        {
+        Sample_t out;
+        bool const fOut = decimator.put(Sample_t(i), out);
+
+        fCadence = fCadence && fOut == (i % 4 == 3);
+        // mean of i-3 .. i is i - 1.5, rounded up.
+        if (fOut)
+            fValue = fValue && out == Sample_t(i - 1);
+        }
+
+    check(fCadence, "cDecimator<4> emits on every fourth sample");
+    check(fValue, "cDecimator<4> emits the rounded mean");
+
+    cFilterPipeline<cMedianFilter<3>, cDecimator<10>> pipeline;
+    unsigned nOut = 0;
+
+    for (unsigned i = 0; i < 1000; ++i)
+        {
+        Sample_t out;
+
+        if (pipeline.put(Sample_t(i), out))
+            ++nOut;
+        }
+
+    check(nOut == 100, "cFilterPipeline output cadence follows its decimator");
+    }
+
+/// \brief A sensor on its own bus (the SGPC3's address is fixed).
+struct SimNode
+    {
+    SimNode(const SimSGPC3::Config_t &config, std::uint32_t seed)
+        : device(config, seed)
+        , sensor(bus)
+        {
+        bus.attach(&device);
+        }
+
+    TwoWire bus;
+    SimSGPC3 device;
+    cSGPC3 sensor;
+    };
+
+using Registry = cSGPC3_Registry<std::uint16_t, 8>;
+
+void loadCalibration(Registry::Entry_t &entry, void *pClientData)
+    {
+    ++*static_cast<unsigned *>(pClientData);
+    entry.calibration = std::uint16_t(entry.serialId);
+    entry.fCalibration = true;
+    }
+
+/// \brief Scan \p nSensors simulated sensors; return the scan time in microseconds.
+///
+/// \param nSensors [in]    Number of sensors, at most 8.
+/// \param iFailed [in]     Index of a sensor that NACKs everything, or \p nSensors for none.
+/// \param fPass [out]      Set \c false if the registry's results are wrong.
+std::uint64_t scanSensors(unsigned nSensors, unsigned iFailed, bool &fPass)
+    {
+    std::vector<std::unique_ptr<SimNode>> nodes;
+    Registry registry;
+    unsigned nLoaded = 0;
+
+    HostClock::setNow(0);
+
+    for (unsigned i = 0; i < nSensors; ++i)
+        {
+        SimSGPC3::Config_t config = {};
+
+        config.nackPpm = i == iFailed ? 1000000 : 0;
+        config.serialId = 0x0000A5A50000ull + i;
+        nodes.emplace_back(new SimNode(config, i + 1));
+        registry.add(nodes.back()->sensor);
+        }
+
+    // start after the power-up time, so that only the scan is timed.
+    HostClock::setNow(1000000);
+    auto const tStart = HostClock::getNow();
+    auto const nIdentified = registry.scan(loadCalibration, &nLoaded);
+    auto const tScan = HostClock::getNow() - tStart;
+
+    unsigned const nExpected = nSensors - (iFailed < nSensors);
+
+    fPass = nIdentified == nExpected && nLoaded == nExpected && registry.size() == nSensors;
+    for (unsigned i = 0; i < nSensors; ++i)
+        {
+        auto const serialId = 0x0000A5A50000ull + i;
+        auto const pEntry = registry.find(serialId);
+
+        if (i == iFailed)
+            fPass = fPass && pEntry == nullptr && ! cSGPC3::isSuccess(registry.getEntry(i)->status);
+        else
+            fPass = fPass && pEntry != nullptr &&
+                    pEntry->pSensor == &nodes[i]->sensor &&
+                    registry.find(nodes[i]->sensor) == pEntry &&
+                    pEntry->fCalibration && pEntry->calibration == std::uint16_t(serialId) &&
+                    pEntry->getBaseline() == nullptr;
+        }
+
+    return tScan;
+    }
+
+/// \brief Check cSGPC3_Registry::scan() against simulated sensors.
+void checkRegistry()
+    {
+    bool fPass1, fPass8, fPassFailed;
+    auto const tOne = scanSensors(1, 1, fPass1);
+    auto const tEight = scanSensors(8, 8, fPass8);
+
+    scanSensors(8, 3, fPassFailed);
+
+    check(fPass1 && fPass8, "cSGPC3_Registry::scan() identifies every sensor and calls the loader");
+    check(fPassFailed, "cSGPC3_Registry::scan() reports a sensor that doesn't answer");
+
+    // both scans do the same work per sensor; interleaving should hide
+    // the command delays of the extra sensors, leaving their bus time.
+    std::printf("scan time: 1 sensor %.3f ms, 8 sensors %.3f ms (%.3f ms one at a time)\n",
+                tOne / 1000.0, tEight / 1000.0, 8 * tOne / 1000.0);
+    check(tEight < 2 * tOne, "cSGPC3_Registry::scan() of 8 sensors takes less than twice a scan of one");
+    }
+
+/// \brief A simulated SGPC3 that can be told to NACK writes.
+class NackingSGPC3 : public SimSGPC3
+    {
+public:
+    NackingSGPC3(const Config_t &config)
+        : SimSGPC3(config, 1)
+        , fNack(false)
+        {}
+
+    virtual std::uint8_t onWrite(std::uint8_t address, const std::uint8_t *pBuf, std::size_t nBuf) override
+        {
+        return this->fNack ? 2 : SimSGPC3::onWrite(address, pBuf, nBuf);
+        }
+
+    bool fNack;
+    };
+
+/// \brief Check that a failed or reset split-phase command can't be finished.
+void checkSplitPhase()
+    {
+    SimSGPC3::Config_t config = {};
+    std::uint16_t featureSet;
+    cBusArbiter::Millisecond_t tDue;
+
+    HostClock::setNow(0);
+
+    TwoWire bus;
+    NackingSGPC3 device(config);
+    cSGPC3 sensor(bus);
+
+    bus.attach(&device);
+    bool fPass = cSGPC3::isSuccess(sensor.begin());
+
+    // a started command, then a command whose write fails.
+    fPass = fPass && cSGPC3::isSuccess(sensor.get_serial_id_start());
+    device.fNack = true;
+    fPass = fPass && sensor.get_feature_set_start() == cSGPC3::Error_t::WriteError;
+    device.fNack = false;
+    fPass = fPass && ! sensor.getNextBusTime(tDue);
+    fPass = fPass && sensor.get_feature_set_finish(featureSet) == cSGPC3::Error_t::Failure;
+
+    check(fPass, "a failed write abandons the split-phase command in progress");
+
+    // a started command, then a chip reset.
+    fPass = cSGPC3::isSuccess(sensor.get_feature_set_start());
+    sensor.handleChipReset();
+    fPass = fPass && ! sensor.getNextBusTime(tDue);
+    fPass = fPass && sensor.get_feature_set_finish(featureSet) == cSGPC3::Error_t::Failure;
+
+    check(fPass, "a chip reset abandons the split-phase command in progress");
+    }
+
+/// \brief A fake bus client with a queue of fixed-length jobs.
+class FakeClient : public cBusArbiter::cClient
+    {
+public:
+    /// \brief When a job ran, in microseconds.
+    struct Run_t
+        {
+        std::uint64_t tStartUs;
+        std::uint64_t tEndUs;
+        };
+
+    FakeClient(unsigned nJobs, cBusArbiter::Microsecond_t jobUs)
+        : m_nJobs(nJobs)
+        , m_jobUs(jobUs)
+        , m_fDue(false)
+        , m_tDue(0)
+        {}
+
+    /// \brief Report (or stop reporting) a future bus time.
+    void setDue(bool fDue, cBusArbiter::Millisecond_t tDue = 0)
+        {
+        this->m_fDue = fDue;
+        this->m_tDue = tDue;
+        }
+
+    const std::vector<Run_t> &getRuns() const
+        {
+        return this->m_runs;
+        }
+
+    virtual cBusArbiter::Microsecond_t getPendingBusTimeUs() const override
+        {
+        return this->m_nJobs != 0 ? this->m_jobUs : 0;
+        }
+
+    virtual void pollBus() override
+        {
+        Run_t run;
+
+        --this->m_nJobs;
+        run.tStartUs = HostClock::getNow();
+        HostClock::advance(this->m_jobUs);
+        run.tEndUs = HostClock::getNow();
+        this->m_runs.push_back(run);
+        }
+
+    virtual bool getNextBusTime(cBusArbiter::Millisecond_t &tDue) const override
+        {
+        tDue = this->m_tDue;
+        return this->m_fDue;
+        }
+
+private:
+    unsigned m_nJobs;
+    cBusArbiter::Microsecond_t m_jobUs;
+    bool m_fDue;
+    cBusArbiter::Millisecond_t m_tDue;
+    std::vector<Run_t> m_runs;
+    };
+
+/// \brief Records the start time of the sensor's transactions.
+class StartObserver : public cSGPC3::cObserver
+    {
+public:
+    virtual void onTransaction(const cSGPC3::Transaction_t &t) override
+        {
+        this->tStartUs.push_back(t.tStartUs);
+        }
+
+    std::vector<std::uint32_t> tStartUs;
+    };
+
+/// \brief Check cBusArbiterSimple with an SGPC3 and fake clients.
+void checkArbiter()
+    {
+    auto const kGuardUs = cBusArbiterSimple::kGuardUs;
+    SimSGPC3::Config_t config = {};
+
+    // background work fills the SGPC3's command window, but stops short of it.
+        {
+        HostClock::setNow(0);
+
+        SimNode node(config, 1);
+        cBusArbiterSimple arbiter;
+        FakeClient background(100, 7000);
+
+        node.sensor.begin(cSGPC3::PowerMode_t::Low);
+        node.sensor.setArbiter(&arbiter);
+        arbiter.registerClient(background, cBusArbiter::Priority_t::Low);
+
+        std::uint16_t tvoc;
+        auto const tCallUs = HostClock::getNow();
+        auto const result = node.sensor.measure_tvoc_synchronous(tvoc);
+        // the sensor's window ended when the response became available.
+        auto const tUntilUs = std::uint64_t(node.sensor.getAvailableTime()) * 1000;
+        bool fInWindow = ! background.getRuns().empty();
+
+        for (auto const &run : background.getRuns())
+            fInWindow = fInWindow && run.tStartUs >= tCallUs && run.tEndUs + kGuardUs <= tUntilUs;
+
+        // ... and leaves no room for another job.
+        bool const fFilled = fInWindow && background.getRuns().back().tEndUs + kGuardUs + 7000 > tUntilUs;
+
+        check(cSGPC3::isSuccess(result) && fInWindow && fFilled,
+              "cBusArbiterSimple runs pending work in the SGPC3's command window, ending by tUntil - kGuardUs");
+        }
+
+    // in acquire(), higher-priority clients run first; lower-priority ones wait.
+        {
+        HostClock::setNow(0);
+
+        SimNode node(config, 2);
+        cBusArbiterSimple arbiter;
+        FakeClient urgent(2, 500);
+        FakeClient background(1, 500);
+        StartObserver observer;
+
+        node.sensor.begin(cSGPC3::PowerMode_t::Low);
+        node.sensor.addObserver(observer);
+        node.sensor.setArbiter(&arbiter);
+        arbiter.registerClient(urgent, cBusArbiter::Priority_t::High);
+        arbiter.registerClient(background, cBusArbiter::Priority_t::Low);
+
+        std::uint16_t tvoc;
+        node.sensor.measure_tvoc_synchronous(tvoc);
+
+        auto const tWriteUs = observer.tStartUs.empty() ? 0 : observer.tStartUs[0];
+        bool fPass = urgent.getRuns().size() == 2 && background.getRuns().size() == 1;
+
+        for (auto const &run : urgent.getRuns())
+            fPass = fPass && run.tEndUs <= tWriteUs;
+        for (auto const &run : background.getRuns())
+            fPass = fPass && run.tStartUs > tWriteUs;
+
+        check(fPass, "cBusArbiterSimple::acquire() runs higher-priority clients first");
+        }
+
+    // low-priority work is held back from a higher-priority client's bus time.
+        {
+        cBusArbiterSimple arbiter;
+        FakeClient waiter(0, 0);
+        FakeClient urgent(0, 0);
+        FakeClient background(5, 10000);
+
+        arbiter.registerClient(waiter, cBusArbiter::Priority_t::Normal);
+        arbiter.registerClient(urgent, cBusArbiter::Priority_t::High);
+        arbiter.registerClient(background, cBusArbiter::Priority_t::Low);
+
+        HostClock::setNow(1000000);
+        auto const tNow = millis();
+        cBusArbiter::Millisecond_t const tDue = tNow + 25;
+
+        urgent.setDue(true, tDue);
+        arbiter.waitIdle(waiter, tNow + 100);
+
+        auto const &runs = background.getRuns();
+        bool fPass = runs.size() >= 2;
+
+        for (auto const &run : runs)
+            {
+            // each run either ends (with the guard) by tDue, or starts after it.
+            fPass = fPass &&
+                    (run.tEndUs + kGuardUs <= std::uint64_t(tDue) * 1000 ||
+                     run.tStartUs >= std::uint64_t(tDue) * 1000) &&
+                    run.tEndUs + kGuardUs <= std::uint64_t(tNow + 100) * 1000;
+            }
+
+        check(fPass, "cBusArbiterSimple holds back low-priority work that would overlap a higher-priority bus time");
+        }
+    }
+
+} // namespace
+
+int main()
+    {
+    checkSortedWindow();
+    checkHampel();
+    checkDecimator();
+    checkRegistry();
+    checkArbiter();
+    checkSplitPhase();
+
+    std::printf("%u check(s) failed\n", gnFailed);
+    return gnFailed == 0 ? 0 : 1;
+    }
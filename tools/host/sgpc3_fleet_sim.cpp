@@ -0,0 +1,458 @@
+/*
+
+Module: sgpc3_fleet_sim.cpp
+
+Function:
+    Host-only load test: many cSGPC3 drivers served by one host executor.
+
+Copyright and License:
+    See accompanying LICENSE file.
+
+Author:
+    Terry Moore, MCCI Corporation   May 2020
+
+Build:
+    From the top of the repository:
+
+        g++ -std=c++11 -O2 -Itools/host -Isrc -o sgpc3_fleet_sim \
+            tools/host/sgpc3_fleet_sim.cpp tools/host/SimSGPC3.cpp \
+            tools/host/HostArduino.cpp src/lib/MCCI_Catena_SGPC3*.cpp
+
+Usage:
+    sgpc3_fleet_sim [--sensors=N] [--seconds=S] [--ultralow] [--adaptive]
+                    [--split] [--crc-ppm=P] [--nack-ppm=P] [--seed=N]
+                    [--trace=FILE]
+
+    Each sensor has its own simulated bus (as if behind an I2C mux), but
+    all of them are served by a single host executor, on one virtual
+    clock that never runs backwards. While the executor is inside a
+    driver call, no other sensor is served; so a read is delayed by the
+    calls for other sensors that were due before it, and latency is
+    measured from when the read was due to when it completed.
+
+    Every read is a `measure_tvoc`, whatever the options, so that runs
+    differ only in scheduling. By default, reads use the blocking API,
+    so the executor waits out every command delay. --split starts each read with the split-phase
+    API and collects the response when it's ready, so the executor
+    serves other sensors during the delay.
+
+    begin() waits out the sensor's power-up time, so with one executor
+    the fleet starts one sensor at a time; the startup latency shows
+    this. Reads that fall due before the last sensor has started are
+    delayed by start-ups, so the steady-state latency is also reported,
+    counting only reads due after that.
+
+    --adaptive reads each sensor under control of cSGPC3_RateController,
+    instead of at every sensor update.
+
+    --trace=FILE records the last transactions of the first sensor with
+    cSGPC3_TraceRecorder, and dumps them to FILE for sgpc3_trace_replay.
+
+*/
+
+/// \file
+
+#include <MCCI_Catena_SGPC3.h>
+#include <MCCI_Catena_SGPC3_RateController.h>
+#include <MCCI_Catena_SGPC3_Trace.h>
+#include "SimSGPC3.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <queue>
+#include <vector>
+
+using namespace McciCatenaSGPC3;
+
+namespace {
+
+/// \brief Driver with the split-phase measurement exposed.
+class FleetSGPC3 : public cSGPC3
+    {
+public:
+    FleetSGPC3(TwoWire &wire)
+        : cSGPC3(wire)
+        {}
+
+    Error_t measureStart()
+        {
+        return this->sendAsync<Command_t::measure_tvoc>();
+        }
+
+    Error_t measureFinish(std::uint16_t &tvoc)
+        {
+        return this->getAsyncResponse<Command_t::measure_tvoc>(tvoc);
+        }
+    };
+
+/// \brief One simulated node: a bus, a device, and a driver.
+struct Node
+    {
+    Node(const SimSGPC3::Config_t &config, std::uint32_t seed)
+        : device(config, seed)
+        , sensor(bus)
+        , controller(sensor)
+        , tDueUs(0)
+        , fStarted(false)
+        , fPending(false)
+        {
+        bus.attach(&device);
+        }
+
+    TwoWire bus;
+    SimSGPC3 device;
+    FleetSGPC3 sensor;
+    cSGPC3_RateController controller;
+    std::uint64_t tDueUs;           ///< When the next (or current) read was due.
+    bool fStarted;
+    bool fPending;                  ///< A split-phase read awaits its response.
+    };
+
+/// \brief A \c Print that writes to a file.
+class FilePrint : public Print
+    {
+public:
+    FilePrint(std::FILE *fp)
+        : m_fp(fp)
+        {}
+
+    virtual std::size_t write(std::uint8_t b) override
+        {
+        return std::fputc(b, this->m_fp) == EOF ? 0 : 1;
+        }
+
+private:
+    std::FILE *m_fp;
+    };
+
+struct Options
+    {
+    unsigned nSensors = 1000;
+    unsigned seconds = 3600;
+    bool fUltraLow = false;
+    bool fAdaptive = false;
+    bool fSplit = false;
+    std::uint32_t crcPpm = 100;
+    std::uint32_t nackPpm = 100;
+    std::uint32_t seed = 1;
+    const char *pTraceFile = nullptr;
+    };
+
+bool parseArg(const char *arg, const char *name, std::uint32_t &value)
+    {
+    auto const n = std::strlen(name);
+
+    if (std::strncmp(arg, name, n) != 0 || arg[n] != '=')
+        return false;
+
+    value = std::uint32_t(std::strtoul(arg + n + 1, nullptr, 0));
+    return true;
+    }
+
+bool parseOptions(int argc, char **argv, Options &opts)
+    {
+    for (int i = 1; i < argc; ++i)
+        {
+        std::uint32_t v;
+        const char *arg = argv[i];
+
+        if (parseArg(arg, "--sensors", v))
+            opts.nSensors = v;
+        else if (parseArg(arg, "--seconds", v))
+            opts.seconds = v;
+        else if (parseArg(arg, "--crc-ppm", v))
+            opts.crcPpm = v;
+        else if (parseArg(arg, "--nack-ppm", v))
+            opts.nackPpm = v;
+        else if (parseArg(arg, "--seed", v))
+            opts.seed = v;
+        else if (std::strcmp(arg, "--ultralow") == 0)
+            opts.fUltraLow = true;
+        else if (std::strcmp(arg, "--adaptive") == 0)
+            opts.fAdaptive = true;
+        else if (std::strcmp(arg, "--split") == 0)
+            opts.fSplit = true;
+        else if (std::strncmp(arg, "--trace=", 8) == 0)
+            opts.pTraceFile = arg + 8;
+        else
+            {
+            std::fprintf(stderr, "unknown option: %s\n", arg);
+            return false;
+            }
+        }
+
+    return opts.nSensors > 0;
+    }
+
+/// \brief Return the given percentile of a set of samples (which is reordered).
+std::uint64_t percentile(std::vector<std::uint64_t> &v, unsigned pct)
+    {
+    if (v.empty())
+        return 0;
+
+    auto const i = (v.size() - 1) * pct / 100;
+    std::nth_element(v.begin(), v.begin() + i, v.end());
+    return v[i];
+    }
+
+const char *errorName(cSGPC3::Error_t e)
+    {
+    switch (e)
+        {
+    case cSGPC3::Error_t::Success:              return "Success";
+    case cSGPC3::Error_t::Failure:              return "Failure";
+    case cSGPC3::Error_t::InvalidParmameter:    return "InvalidParameter";
+    case cSGPC3::Error_t::NotSupported:         return "NotSupported";
+    case cSGPC3::Error_t::WrongDeviceType:      return "WrongDeviceType";
+    case cSGPC3::Error_t::WriteError:           return "WriteError";
+    case cSGPC3::Error_t::ReadError:            return "ReadError";
+    case cSGPC3::Error_t::BadCRC:               return "BadCRC";
+    default:                                    return "?";
+        }
+    }
+
+} // namespace
+
+int main(int argc, char **argv)
+    {
+    Options opts;
+
+    if (! parseOptions(argc, argv, opts))
+        {
+        std::fprintf(stderr, "usage: %s [--sensors=N] [--seconds=S] [--ultralow] [--adaptive] [--split] [--crc-ppm=P] [--nack-ppm=P] [--seed=N] [--trace=FILE]\n", argv[0]);
+        return 1;
+        }
+
+    auto const mode = opts.fUltraLow ? cSGPC3::PowerMode_t::UltraLow : cSGPC3::PowerMode_t::Low;
+    std::uint64_t const periodUs = 1000 * std::uint64_t(opts.fUltraLow ? cSGPC3::kTultraLowPowerMs : cSGPC3::kTlowPowerMs);
+    std::uint64_t const tEndUs = std::uint64_t(opts.seconds) * 1000000;
+    std::uint64_t const kRetryUs = 1000000;
+
+    // build the fleet; stagger start times over one period.
+    std::vector<std::unique_ptr<Node>> fleet;
+    fleet.reserve(opts.nSensors);
+
+    HostClock::setNow(0);
+
+    for (unsigned i = 0; i < opts.nSensors; ++i)
+        {
+        SimSGPC3::Config_t config;
+
+        config.crcErrorPpm = opts.crcPpm;
+        config.nackPpm = opts.nackPpm;
+        config.preheatMs = opts.fUltraLow ? 184000 : 64000;
+        config.serialId = 0x0000A5A50000ull + i;
+
+        fleet.emplace_back(new Node(config, opts.seed * 7919u + i));
+        fleet.back()->tDueUs = periodUs * i / opts.nSensors;
+        }
+
+    static cSGPC3_TraceRecorder<1024> trace;
+
+    if (opts.pTraceFile != nullptr)
+        fleet[0]->sensor.addObserver(trace);
+
+    // discrete-event loop: the executor always serves the earliest event.
+    // An event is either a read (or start-up) falling due, or, with --split,
+    // the response of a started read becoming ready.
+    using Event = std::pair<std::uint64_t, unsigned>;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+
+    for (unsigned i = 0; i < fleet.size(); ++i)
+        events.push(Event(fleet[i]->tDueUs, i));
+
+    std::vector<std::uint64_t> measureLatencyUs;
+    std::vector<std::uint64_t> measureDueUs;
+    std::vector<std::uint64_t> startLatencyUs;
+    std::uint64_t errorCounts[8] = {};
+    std::uint64_t nOps = 0;
+    std::uint64_t nLate = 0;
+    std::uint64_t executorBusyUs = 0;
+
+    measureLatencyUs.reserve(std::size_t(opts.nSensors) * (tEndUs / periodUs + 1));
+    measureDueUs.reserve(measureLatencyUs.capacity());
+
+    // when the last sensor started; reads due after this are steady-state.
+    unsigned nRunning = 0;
+    std::uint64_t tAllStartedUs = tEndUs;
+
+    auto const tWallStart = std::chrono::steady_clock::now();
+
+    while (! events.empty())
+        {
+        auto const ev = events.top();
+        events.pop();
+
+        auto &node = *fleet[ev.second];
+        if (ev.first >= tEndUs || HostClock::getNow() >= tEndUs)
+            continue;
+
+        // the executor can't start before it has finished the previous call.
+        if (HostClock::getNow() < ev.first)
+            HostClock::setNow(ev.first);
+
+        auto const tStartUs = HostClock::getNow();
+        cSGPC3::Error_t result;
+        bool fReadDone = false;
+
+        if (! node.fStarted)
+            {
+            // begin() treats the call as a chip reset; match it on the device.
+            node.device.powerOn();
+            result = node.sensor.begin(mode);
+            if (cSGPC3::isSuccess(result))
+                {
+                node.fStarted = true;
+                node.controller.reset();
+                startLatencyUs.push_back(HostClock::getNow() - node.tDueUs);
+                if (++nRunning == fleet.size())
+                    tAllStartedUs = HostClock::getNow();
+                }
+            }
+        else if (opts.fSplit && ! node.fPending)
+            {
+            result = node.sensor.measureStart();
+            if (cSGPC3::isSuccess(result))
+                {
+                // come back when the response is ready.
+                node.fPending = true;
+                executorBusyUs += HostClock::getNow() - tStartUs;
+                events.push(Event(std::uint64_t(node.sensor.getAvailableTime()) * 1000, ev.second));
+                continue;
+                }
+            fReadDone = true;
+            }
+        else
+            {
+            std::uint16_t tvoc;
+
+            if (node.fPending)
+                {
+                node.fPending = false;
+                result = node.sensor.measureFinish(tvoc);
+                }
+            else
+                result = node.sensor.measure_tvoc_synchronous(tvoc);
+
+            if (cSGPC3::isSuccess(result) && opts.fAdaptive)
+                node.controller.update(tvoc, millis());
+            fReadDone = true;
+            }
+
+        auto const tNow = HostClock::getNow();
+
+        executorBusyUs += tNow - tStartUs;
+        ++nOps;
+        ++errorCounts[unsigned(result) & 7];
+
+        if (fReadDone)
+            {
+            measureLatencyUs.push_back(tNow - node.tDueUs);
+            measureDueUs.push_back(node.tDueUs);
+            if (tNow - node.tDueUs > periodUs)
+                ++nLate;
+            }
+
+        if (! node.fStarted)
+            node.tDueUs = tNow + kRetryUs;
+        else if (! fReadDone)
+            node.tDueUs = tNow;
+        else if (opts.fAdaptive &&
+                 (cSGPC3::isSuccess(result) || node.controller.getReadCount() == 0))
+            node.tDueUs = std::uint64_t(node.controller.getNextReadTime()) * 1000;
+        else
+            {
+            // a failed adaptive read retries next period.
+            node.tDueUs += periodUs;
+            }
+
+        // if we're behind, the read is due now.
+        if (node.tDueUs < tNow)
+            node.tDueUs = tNow;
+
+        events.push(Event(node.tDueUs, ev.second));
+        }
+
+    auto const wallNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - tWallStart
+                            ).count();
+
+    if (opts.pTraceFile != nullptr)
+        {
+        std::FILE *fp = std::fopen(opts.pTraceFile, "w");
+
+        if (fp == nullptr)
+            std::perror(opts.pTraceFile);
+        else
+            {
+            FilePrint out(fp);
+
+            trace.dump(out);
+            std::fclose(fp);
+            }
+        }
+
+    // report.
+    std::uint64_t busyUs = 0;
+    unsigned nStarted = 0;
+
+    for (auto &pNode : fleet)
+        {
+        busyUs += pNode->bus.getBusyUs();
+        nStarted += pNode->fStarted;
+        }
+
+    std::vector<std::uint64_t> steadyLatencyUs;
+
+    for (std::size_t i = 0; i < measureDueUs.size(); ++i)
+        {
+        if (measureDueUs[i] >= tAllStartedUs)
+            steadyLatencyUs.push_back(measureLatencyUs[i]);
+        }
+
+    auto const nMeasure = measureLatencyUs.size();
+
+    std::printf("sensors:              %u (%u started)\n", opts.nSensors, nStarted);
+    std::printf("simulated time:       %u s, %s mode, %s %s reads\n",
+                opts.seconds,
+                opts.fUltraLow ? "ultra-low-power" : "low-power",
+                opts.fAdaptive ? "adaptive" : "periodic",
+                opts.fSplit ? "split-phase" : "blocking");
+    std::printf("injected faults:      crc %u ppm, nack %u ppm\n", unsigned(opts.crcPpm), unsigned(opts.nackPpm));
+    std::printf("operations:           %llu\n", (unsigned long long) nOps);
+    for (unsigned i = 0; i < 8; ++i)
+        {
+        if (errorCounts[i] != 0)
+            std::printf("  %-20s%llu\n", errorName(cSGPC3::Error_t(i)), (unsigned long long) errorCounts[i]);
+        }
+    std::printf("throughput:           %.1f measurements/s\n", double(errorCounts[0] - nStarted) / opts.seconds);
+    std::printf("measurement latency:  p50 %.3f ms, p99 %.3f ms, max %.3f ms (%zu samples, due to done)\n",
+                percentile(measureLatencyUs, 50) / 1000.0,
+                percentile(measureLatencyUs, 99) / 1000.0,
+                percentile(measureLatencyUs, 100) / 1000.0,
+                nMeasure);
+    if (steadyLatencyUs.empty())
+        std::printf("steady-state latency: none (the fleet was still starting)\n");
+    else
+        std::printf("steady-state latency: p50 %.3f ms, p99 %.3f ms, max %.3f ms (%zu samples, due after %.3f s)\n",
+                    percentile(steadyLatencyUs, 50) / 1000.0,
+                    percentile(steadyLatencyUs, 99) / 1000.0,
+                    percentile(steadyLatencyUs, 100) / 1000.0,
+                    steadyLatencyUs.size(),
+                    tAllStartedUs / 1e6);
+    std::printf("late reads:           %llu (more than one period after due)\n", (unsigned long long) nLate);
+    std::printf("startup latency:      p50 %.3f ms, p99 %.3f ms\n",
+                percentile(startLatencyUs, 50) / 1000.0,
+                percentile(startLatencyUs, 99) / 1000.0);
+    std::printf("executor utilization: %.2f %%\n", 100.0 * double(executorBusyUs) / double(tEndUs));
+    std::printf("bus utilization:      %.4f %% per sensor bus, %.2f %% of the host controller\n",
+                100.0 * double(busyUs) / (double(tEndUs) * opts.nSensors),
+                100.0 * double(busyUs) / double(tEndUs));
+    std::printf("host cost:            %.1f ns/operation\n", nOps ? double(wallNs) / nOps : 0.0);
+
+    return 0;
+    }
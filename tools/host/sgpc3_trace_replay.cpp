@@ -0,0 +1,495 @@
+/*
+
+Module: sgpc3_trace_replay.cpp
+
+Function:
+    Host tool: profile and replay a trace dumped by cSGPC3_TraceRecorder.
+
+Copyright and License:
+    See accompanying LICENSE file.
+
+Author:
+    Terry Moore, MCCI Corporation   May 2020
+
+Build:
+    From the top of the repository:
+
+        g++ -std=c++11 -O2 -Itools/host -Isrc -o sgpc3_trace_replay \
+            tools/host/sgpc3_trace_replay.cpp tools/host/SimSGPC3.cpp \
+            tools/host/HostArduino.cpp src/lib/MCCI_Catena_SGPC3*.cpp
+
+Usage:
+    sgpc3_trace_replay [--ultralow] [tracefile]
+
+    Reads the trace (from standard input if no file is given), reports
+    per-command timing and error statistics as recorded in the field,
+    then replays the trace through cSGPC3 against a mock bus that returns
+    the recorded bytes, and reports what the driver made of it, how long
+    it took in virtual time, and the estimated energy.
+
+    If the trace doesn't start with the sensor being initialized (for
+    example, because the recorder's ring wrapped), the energy model is
+    started with the sensor running, in the power mode of the first
+    recorded `set_power_mode`; if there is none, in low-power mode, or
+    ultra-low-power mode if --ultralow is given.
+
+*/
+
+/// \file
+
+#include <MCCI_Catena_SGPC3.h>
+#include <MCCI_Catena_SGPC3_Energy.h>
+#include <MCCI_Catena_SGPC3_Trace.h>
+#include "SimSGPC3.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <vector>
+
+using namespace McciCatenaSGPC3;
+
+namespace {
+
+/// \brief Timing and error statistics for one command code.
+struct CommandProfile
+    {
+    std::vector<std::uint64_t> durationsUs;
+    std::uint32_t errors[8] = {};
+    std::uint32_t nBadCrc = 0;
+    };
+
+using Profile = std::map<std::uint16_t, CommandProfile>;
+
+const char *commandName(std::uint16_t code)
+    {
+    switch (code)
+        {
+    case 0x2008:    return "measure_tvoc";
+    case 0x2015:    return "get_tvoc_baseline";
+    case 0x201e:    return "set_tvoc_baseline";
+    case 0x202f:    return "get_feature_set_version";
+    case 0x2032:    return "measure_test";
+    case 0x2046:    return "measure_tvoc_and_raw";
+    case 0x204d:    return "measure_raw";
+    case 0x2061:    return "set_absolute_humidity";
+    case 0x2089:    return "tvoc_init_no_preheat";
+    case 0x209f:    return "set_power_mode";
+    case 0x20ae:    return "tvoc_init_continuous";
+    case 0x20b3:    return "get_tvoc_inceptive_baseline";
+    case 0x3682:    return "get_serial_id";
+    default:        return "?";
+        }
+    }
+
+const char *errorName(unsigned e)
+    {
+    static const char * const names[] =
+        {
+        "Success", "Failure", "InvalidParameter", "NotSupported",
+        "WrongDeviceType", "WriteError", "ReadError", "BadCRC",
+        };
+
+    return e < sizeof(names) / sizeof(names[0]) ? names[e] : "?";
+    }
+
+int hexValue(char c)
+    {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+    }
+
+/// \brief Read a trace in the format written by cSGPC3_TraceRecorder::dump().
+bool readTrace(std::FILE *fp, std::vector<SGPC3_TraceRecord_t> &records, unsigned long &nDropped)
+    {
+    char line[256];
+    bool fInTrace = false;
+
+    while (std::fgets(line, sizeof(line), fp) != nullptr)
+        {
+        unsigned version;
+        unsigned long nRecords;
+
+        if (! fInTrace)
+            {
+            // skip anything else the serial monitor captured.
+            if (std::sscanf(line, "SGPC3TRACE %u %lu %lu", &version, &nRecords, &nDropped) == 3)
+                {
+                if (version != cSGPC3_TraceRecorder<1>::kFormatVersion)
+                    {
+                    std::fprintf(stderr, "unsupported trace version %u\n", version);
+                    return false;
+                    }
+                fInTrace = true;
+                records.reserve(nRecords);
+                }
+            continue;
+            }
+
+        if (std::strncmp(line, "SGPC3TRACE END", 14) == 0)
+            return true;
+
+        std::uint8_t bytes[sizeof(SGPC3_TraceRecord_t)];
+        unsigned i;
+
+        for (i = 0; i < sizeof(bytes); ++i)
+            {
+            int const hi = hexValue(line[2 * i]);
+            int const lo = hi < 0 ? -1 : hexValue(line[2 * i + 1]);
+
+            if (lo < 0)
+                break;
+            bytes[i] = std::uint8_t((hi << 4) | lo);
+            }
+
+        if (i != sizeof(bytes))
+            {
+            std::fprintf(stderr, "malformed record %zu\n", records.size());
+            return false;
+            }
+
+        SGPC3_TraceRecord_t r;
+        std::memcpy(&r, bytes, sizeof(r));
+        records.push_back(r);
+        }
+
+    std::fprintf(stderr, "%s\n", fInTrace ? "trace is truncated" : "no trace found");
+    return false;
+    }
+
+/// \brief Check the CRCs of a recorded response.
+bool responseCrcOk(const SGPC3_TraceRecord_t &r)
+    {
+    for (unsigned i = 0; i + 3 <= r.nResponse; i += 3)
+        {
+        if (SimSGPC3::crc(r.response + i, 2) != r.response[i + 2])
+            return false;
+        }
+    return true;
+    }
+
+/// \brief Mock device that plays back the recorded bus responses.
+class ReplayDevice : public HostI2cDevice
+    {
+public:
+    ReplayDevice()
+        : m_pRecord(nullptr)
+        , m_nMismatched(0)
+        {}
+
+    void setRecord(const SGPC3_TraceRecord_t *pRecord)
+        {
+        this->m_pRecord = pRecord;
+        }
+
+    std::uint32_t getMismatchCount() const
+        {
+        return this->m_nMismatched;
+        }
+
+    virtual std::uint8_t onWrite(std::uint8_t address, const std::uint8_t *pBuf, std::size_t nBuf) override
+        {
+        (void) address;
+
+        if (this->m_pRecord == nullptr || nBuf < 2)
+            return 2;
+
+        std::uint16_t const cmd = std::uint16_t((pBuf[0] << 8) | pBuf[1]);
+        if (cmd != this->m_pRecord->command)
+            ++this->m_nMismatched;
+
+        return this->m_pRecord->i2cResult;
+        }
+
+    virtual std::size_t onRead(std::uint8_t address, std::uint8_t *pBuf, std::size_t nBuf) override
+        {
+        (void) address;
+
+        if (this->m_pRecord == nullptr)
+            return 0;
+        if (nBuf > this->m_pRecord->nResponse)
+            nBuf = this->m_pRecord->nResponse;
+
+        std::memcpy(pBuf, this->m_pRecord->response, nBuf);
+        return nBuf;
+        }
+
+private:
+    const SGPC3_TraceRecord_t *m_pRecord;
+    std::uint32_t m_nMismatched;
+    };
+
+/// \brief Driver subclass that can issue any command by code.
+class ReplaySGPC3 : public cSGPC3
+    {
+public:
+    ReplaySGPC3(TwoWire &wire)
+        : cSGPC3(wire)
+        {}
+
+    /// \brief Issue the command with the given code, as the field unit did.
+    Error_t issue(std::uint16_t code, std::uint16_t param)
+        {
+        std::uint16_t r1, r2;
+        std::uint64_t r3;
+
+        switch (code)
+            {
+        case 0x2008:    return this->sendAndGetSynchronous<Command_t::measure_tvoc>(r1);
+        case 0x2015:    return this->sendAndGetSynchronous<Command_t::get_tvoc_baseline>(r1);
+        case 0x201e:    return this->sendSynchronous<Command_t::set_tvoc_baseline>(param);
+        case 0x202f:    return this->sendAndGetSynchronous<Command_t::get_feature_set_version>(r1);
+        case 0x2032:    return this->sendAndGetSynchronous<Command_t::measure_test>(r1);
+        case 0x2046:    return this->sendAndGetSynchronous<Command_t::measure_tvoc_and_raw>(r1, r2);
+        case 0x204d:    return this->sendAndGetSynchronous<Command_t::measure_raw>(r1);
+        case 0x2061:    return this->sendSynchronous<Command_t::set_absolute_humidity>(param);
+        case 0x2089:    return this->tvoc_init_no_preheat();
+        case 0x209f:    return this->set_power_mode_synchronous(param == 0 ? PowerMode_t::UltraLow : PowerMode_t::Low);
+        case 0x20ae:    return this->tvoc_init_continuous();
+        case 0x20b3:    return this->sendAndGetSynchronous<Command_t::get_tvoc_inceptive_baseline>(r1);
+        case 0x3682:    return this->sendAndGetSynchronous<Command_t::get_serial_id>(r3);
+        default:        return Error_t::InvalidParmameter;
+            }
+        }
+    };
+
+/// \brief Work out the sensor's state at the start of the trace.
+///
+/// \param records [in]     The trace.
+/// \param nDropped [in]    Number of records lost before the trace.
+/// \param fUltraLow [in]   Power mode to assume if the trace doesn't show it.
+/// \param mode [out]       Set to the power mode to assume.
+/// \param pModeSource [out] Set to a description of where \p mode came from.
+///
+/// \returns
+///     \c true if the sensor must be assumed to be running at the start
+///     of the trace, \c false if the trace shows it being initialized.
+bool findStartingState(
+    const std::vector<SGPC3_TraceRecord_t> &records,
+    unsigned long nDropped,
+    bool fUltraLow,
+    cSGPC3::PowerMode_t &mode,
+    const char *&pModeSource
+    )
+    {
+    bool fRunning = nDropped != 0;
+    bool fFoundStart = false;
+
+    mode = fUltraLow ? cSGPC3::PowerMode_t::UltraLow : cSGPC3::PowerMode_t::Low;
+    pModeSource = fUltraLow ? "from --ultralow" : "default";
+
+    for (auto const &r : records)
+        {
+        if (r.error != 0)
+            continue;
+
+        if (! fFoundStart)
+            {
+            switch (r.command)
+                {
+            case 0x2089:    // tvoc_init_no_preheat
+            case 0x20ae:    // tvoc_init_continuous
+                fRunning = false;
+                fFoundStart = true;
+                break;
+            case 0x2008:    // measure_tvoc
+            case 0x2046:    // measure_tvoc_and_raw
+            case 0x204d:    // measure_raw
+                fRunning = true;
+                fFoundStart = true;
+                break;
+            default:
+                break;
+                }
+            }
+
+        if (r.command == 0x209f)
+            {
+            mode = r.param == 0 ? cSGPC3::PowerMode_t::UltraLow : cSGPC3::PowerMode_t::Low;
+            pModeSource = "from the first recorded set_power_mode";
+            break;
+            }
+        }
+
+    return fRunning;
+    }
+
+std::uint64_t percentile(std::vector<std::uint64_t> v, unsigned pct)
+    {
+    if (v.empty())
+        return 0;
+
+    auto const i = (v.size() - 1) * pct / 100;
+    std::nth_element(v.begin(), v.begin() + i, v.end());
+    return v[i];
+    }
+
+void printProfile(const char *title, const Profile &profile)
+    {
+    std::printf("\n%s\n", title);
+    std::printf("%-28s %7s %9s %9s %9s %9s  errors\n", "command", "count", "min ms", "p50 ms", "p99 ms", "max ms");
+
+    for (auto const &entry : profile)
+        {
+        auto const &p = entry.second;
+        auto const &d = p.durationsUs;
+
+        std::printf("%04x %-23s %7zu %9.3f %9.3f %9.3f %9.3f ",
+                    entry.first, commandName(entry.first), d.size(),
+                    *std::min_element(d.begin(), d.end()) / 1000.0,
+                    percentile(d, 50) / 1000.0,
+                    percentile(d, 99) / 1000.0,
+                    *std::max_element(d.begin(), d.end()) / 1000.0);
+
+        for (unsigned i = 1; i < 8; ++i)
+            {
+            if (p.errors[i] != 0)
+                std::printf(" %s:%u", errorName(i), unsigned(p.errors[i]));
+            }
+        if (p.nBadCrc != 0)
+            std::printf(" crc:%u", unsigned(p.nBadCrc));
+        std::printf("\n");
+        }
+    }
+
+} // namespace
+
+int main(int argc, char **argv)
+    {
+    std::FILE *fp = stdin;
+    const char *pFile = nullptr;
+    bool fUltraLow = false;
+
+    for (int i = 1; i < argc; ++i)
+        {
+        if (std::strcmp(argv[i], "--ultralow") == 0)
+            fUltraLow = true;
+        else if (pFile == nullptr && argv[i][0] != '-')
+            pFile = argv[i];
+        else
+            {
+            std::fprintf(stderr, "usage: %s [--ultralow] [tracefile]\n", argv[0]);
+            return 1;
+            }
+        }
+    if (pFile != nullptr && (fp = std::fopen(pFile, "r")) == nullptr)
+        {
+        std::perror(pFile);
+        return 1;
+        }
+
+    std::vector<SGPC3_TraceRecord_t> records;
+    unsigned long nDropped = 0;
+
+    if (! readTrace(fp, records, nDropped) || records.empty())
+        return 1;
+
+    std::printf("records:  %zu (%lu older records were overwritten on the device)\n", records.size(), nDropped);
+    std::printf("span:     %.3f s\n", std::uint32_t(records.back().tStartMs - records.front().tStartMs) / 1000.0);
+
+    // profile as recorded.
+    Profile recorded;
+    std::vector<std::uint64_t> gapsUs;
+
+    for (std::size_t i = 0; i < records.size(); ++i)
+        {
+        auto const &r = records[i];
+        auto &p = recorded[r.command];
+
+        p.durationsUs.push_back(r.durationUs);
+        ++p.errors[r.error & 7];
+        if (! responseCrcOk(r))
+            ++p.nBadCrc;
+        if (i > 0)
+            gapsUs.push_back(std::uint32_t(r.tStartUs - records[i - 1].tStartUs));
+        }
+
+    printProfile("As recorded (durations from write to completion):", recorded);
+    if (! gapsUs.empty())
+        std::printf("gap between commands: p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+                    percentile(gapsUs, 50) / 1000.0,
+                    percentile(gapsUs, 99) / 1000.0,
+                    *std::max_element(gapsUs.begin(), gapsUs.end()) / 1000.0);
+
+    // replay through the driver against the mock bus.
+    TwoWire bus;
+    ReplayDevice device;
+    ReplaySGPC3 sensor(bus);
+    cSGPC3_EnergyModel energy;
+    SGPC3_TraceRecord_t identify = {};
+    Profile replayed;
+
+    bus.attach(&device);
+
+    // the driver only sends most commands once it knows the feature set.
+    identify.command = 0x202f;
+    identify.nResponse = 3;
+    identify.response[0] = 0x10;
+    identify.response[1] = 0x06;
+    identify.response[2] = SimSGPC3::crc(identify.response, 2);
+    device.setRecord(&identify);
+    HostClock::setNow(0);
+    std::uint16_t featureSet;
+    if (! cSGPC3::isSuccess(sensor.get_feature_set_start()) ||
+        ! cSGPC3::isSuccess(sensor.get_feature_set_finish(featureSet)))
+        {
+        std::fprintf(stderr, "replay: couldn't prime feature set\n");
+        return 1;
+        }
+
+    // replay on a virtual timeline that starts after identification.
+    std::uint64_t const tBaseUs = HostClock::getNow() + 1000000;
+    cSGPC3::PowerMode_t mode;
+    const char *pModeSource;
+    bool const fRunning = findStartingState(records, nDropped, fUltraLow, mode, pModeSource);
+
+    if (fRunning)
+        energy.reset(
+            std::uint32_t(tBaseUs / 1000),
+            mode == cSGPC3::PowerMode_t::UltraLow ? cSGPC3_EnergyModel::State_t::UltraLow : cSGPC3_EnergyModel::State_t::Low,
+            mode
+            );
+    else
+        energy.reset(std::uint32_t(tBaseUs / 1000));
+    sensor.addObserver(energy);
+
+    std::uint32_t nDiffer = 0;
+
+    for (auto const &r : records)
+        {
+        std::uint64_t const tRecordUs = tBaseUs + 1000 * std::uint64_t(std::uint32_t(r.tStartMs - records.front().tStartMs));
+
+        if (HostClock::getNow() < tRecordUs)
+            HostClock::setNow(tRecordUs);
+
+        device.setRecord(&r);
+        auto const tStartUs = HostClock::getNow();
+        auto const result = sensor.issue(r.command, r.param);
+        auto &p = replayed[r.command];
+
+        p.durationsUs.push_back(HostClock::getNow() - tStartUs);
+        ++p.errors[unsigned(result) & 7];
+
+        // the recorder doesn't see CRC failures, which are found later.
+        auto const expected = (r.error == 0 && ! responseCrcOk(r)) ? unsigned(cSGPC3::Error_t::BadCRC) : unsigned(r.error);
+        if (unsigned(result) != expected)
+            ++nDiffer;
+        }
+
+    energy.accumulateTo(millis());
+
+    printProfile("Replayed through cSGPC3 on the host (virtual time, including waits):", replayed);
+    std::printf("command mismatches: %u; results differing from the field: %u\n", unsigned(device.getMismatchCount()), unsigned(nDiffer));
+    if (fRunning)
+        std::printf("assumed start:      running, %s mode (%s)\n",
+                    mode == cSGPC3::PowerMode_t::UltraLow ? "ultra-low-power" : "low-power",
+                    pModeSource);
+    else
+        std::printf("assumed start:      idle (the trace starts with the sensor being initialized)\n");
+    std::printf("estimated energy:   %llu uJ over the trace\n", (unsigned long long) energy.getTotalMicrojoules());
+
+    return 0;
+    }